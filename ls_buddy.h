@@ -0,0 +1,375 @@
+/*
+ * ls_buddy.h - v1.0.0 - buddy allocator over arena chunks - Logan Seeley 2025
+ *
+ * Documentation
+ *
+ *	Behaviour & Safety
+ *
+ *		Serves blocks of LS_BUDDY_MIN_BLOCK_SIZE up to the chunk size of an
+ *		[ls_chunk_arena_s], rounded up to a power of 2. Every chunk taken from
+ *		the arena is the root block of a buddy tree, split in halves on demand
+ *		and coalesced with its buddy on free, in O(log(chunk size)) steps.
+ *
+ *		The state of a tree is kept out of band: a free bit per block and a
+ *		split bit per block that has halves, 3 bits per minimum block, in a
+ *		record drawn from an [ls_object_pool_s]. A directory with a record
+ *		pointer per arena chunk, taken from the arena as one span at init,
+ *		finds the record of a block by address; blocks carry no header and
+ *		freeing needs no size. Free blocks are chained through their first
+ *		16 bytes, one list per size.
+ *
+ *		A tree that becomes whole again is given back to the arena, unless
+ *		it is the last one.
+ *
+ *		The lifetime of any [ls_buddy_s] must be less than that of its arena.
+ *		A buddy allocator uses the non _atomic functions of the arena and must
+ *		be locked along with it.
+ *
+ *	Usage
+ *
+ *		Include [ls_chunk_arena.h] (and define its allocator binding)
+ *		before including this file.
+ *
+ *		Optionally, define [LS_BUDDY_MIN_BLOCK_SIZE] to a power of 2 of
+ *		at least 16 before including this file. Defaults to 64 bytes.
+ *
+ *	Functions
+ *
+ *		ls_buddy_s ls_buddy_init(ls_chunk_arena_s *chunk_arena, ls_result_t *status) - buddy_init
+ *			the chunk size of [chunk_arena] must be at least LS_BUDDY_MIN_BLOCK_SIZE.
+ *			Takes ceil(chunks * 8 / chunk size) chunks for the directory.
+ *			[status] is out
+ *			[*status] = LS_SUCCESS
+ *			[*status] = LS_CHUNK_ARENA_MEM_FULL -> no room for the directory, the buddy allocator must not be used
+ *
+ *		void ls_buddy_fini(ls_buddy_s *buddy) - buddy_fini
+ *			gives every chunk back to the arena, live blocks included.
+ *
+ *		ls_void_p ls_buddy_alloc(ls_buddy_s *buddy, ls_u64_t size, ls_result_t *status) - buddy_alloc
+ *			[status] is out
+ *			[*status] = LS_SUCCESS
+ *			[*status] = LS_CHUNK_ARENA_MEM_FULL -> no free block large enough and the arena is full. [return] will also be LS_NULL
+ *			[*status] = LS_BUDDY_TOO_LARGE -> [size] is larger than a chunk. [return] will also be LS_NULL
+ *
+ *		void ls_buddy_free(ls_buddy_s *buddy, ls_void_p block_p) - buddy_free
+ *			[block_p] must have been returned by [ls_buddy_alloc] of [buddy]
+ *
+ *		ls_u64_t ls_buddy_block_size(ls_buddy_s *buddy, ls_void_p block_p) - buddy_block_size
+ *			returns the usable size of [block_p], [size] rounded up to a power of 2.
+ */
+
+
+#ifndef LS_BUDDY_H
+#define LS_BUDDY_H
+
+
+#include "./ls_macros.h"
+
+#ifndef LS_CHUNK_ARENA_H
+    #error "ls_buddy.h requires ls_chunk_arena.h to be included first"
+#endif
+
+#include "./ls_object_pool.h"
+
+
+#define LS_BUDDY_TOO_LARGE	3
+
+#ifndef LS_BUDDY_MIN_BLOCK_SIZE
+	#define LS_BUDDY_MIN_BLOCK_SIZE	64
+#endif
+
+#if LS_BUDDY_MIN_BLOCK_SIZE < 16 || (LS_BUDDY_MIN_BLOCK_SIZE & (LS_BUDDY_MIN_BLOCK_SIZE - 1))
+	#error "LS_BUDDY_MIN_BLOCK_SIZE must be a power of 2 of at least 16"
+#endif
+
+#define LS_BUDDY_MAX_ORDER_C	64
+
+/*
+ * blocks of a tree are numbered like a heap: the root is 1, the halves of n are
+ * 2n and 2n + 1. a block of order k is LS_BUDDY_MIN_BLOCK_SIZE << k bytes
+ */
+#define LS_BUDDY_NODE(buddy, offset, order) (((buddy)->_leaf_c >> (order)) + ((offset) >> (LS_FLOOR_LOG2(LS_BUDDY_MIN_BLOCK_SIZE) + (order))))
+#define LS_BUDDY_BIT_GET(bitmap, i)		(((bitmap)[(i) / 64] >> ((i) % 64)) & 1)
+#define LS_BUDDY_BIT_SET(bitmap, i)		((bitmap)[(i) / 64] |= 1llu << ((i) % 64))
+#define LS_BUDDY_BIT_CLEAR(bitmap, i)	((bitmap)[(i) / 64] &= ~(1llu << ((i) % 64)))
+
+
+/* first bytes of a free block */
+typedef struct ls_buddy_block_s
+{
+	struct ls_buddy_block_s *_next;
+	struct ls_buddy_block_s *_prev;
+}
+ls_buddy_block_s;
+
+
+typedef struct
+{
+	ls_chunk_arena_s *_chunk_arena;
+
+	/* records of the trees: [_word_c] words of free bits, then [_word_c] / 2 words of split bits */
+	ls_object_pool_s _tree_pool;
+	ls_u64_p   *_tree_a;  /* record of each arena chunk, LS_NULL if it is not a tree */
+	ls_u64_t	_tree_c;
+
+	ls_u64_t	_order_c;  /* order [_order_c] - 1 is a whole chunk */
+	ls_u64_t	_leaf_c;   /* minimum blocks per chunk */
+	ls_u64_t	_word_c;
+
+	ls_buddy_block_s *_free_a[LS_BUDDY_MAX_ORDER_C];
+}
+ls_buddy_s;
+
+
+static ls_buddy_s		ls_buddy_init				(ls_chunk_arena_s 	*chunk_arena, 	ls_result_t 	*status)							LS_LIBFN;
+static void				ls_buddy_fini				(ls_buddy_s 		*buddy)																LS_LIBFN;
+
+static ls_void_p		ls_buddy_alloc				(ls_buddy_s 		*buddy, 		ls_u64_t 		 size, 		ls_result_t *status)	LS_LIBFN;
+static void				ls_buddy_free				(ls_buddy_s 		*buddy, 		ls_void_p 		 block_p)							LS_LIBFN;
+static ls_u64_t			ls_buddy_block_size			(ls_buddy_s 		*buddy, 		ls_void_p 		 block_p)							LS_LIBFN;
+
+static ls_u64_t			_ls_buddy_find				(ls_buddy_s 		*buddy, 		ls_u64_p 		 tree, 		ls_u64_t 	 offset)	LS_LIBFN;
+static ls_bool_t		_ls_buddy_grow				(ls_buddy_s 		*buddy, 		ls_result_t 	*status)							LS_LIBFN;
+static void				_ls_buddy_push				(ls_buddy_s 		*buddy, 		ls_void_p 		 block_p, 	ls_u64_t 	 order)		LS_LIBFN;
+static void				_ls_buddy_unlink			(ls_buddy_s 		*buddy, 		ls_void_p 		 block_p, 	ls_u64_t 	 order)		LS_LIBFN;
+
+
+static LS_INLINE ls_buddy_s ls_buddy_init(ls_chunk_arena_s *chunk_arena, ls_result_t *status)
+{
+	ls_buddy_s buddy;
+	ls_u64_t   dir_size = chunk_arena->_max_chunk_c * sizeof(ls_u64_p);
+
+	buddy._chunk_arena	= chunk_arena;
+	buddy._tree_c		= 0;
+	buddy._leaf_c		= chunk_arena->_chunk_size / LS_BUDDY_MIN_BLOCK_SIZE;
+	buddy._order_c		= LS_FLOOR_LOG2(buddy._leaf_c) + 1;
+	buddy._word_c		= (2 * buddy._leaf_c + 63) / 64;
+
+	buddy._tree_pool	= ls_object_pool_init(chunk_arena, (buddy._word_c + (buddy._leaf_c + 63) / 64) * sizeof(ls_u64_t), sizeof(ls_u64_t));
+	buddy._tree_a		= LS_CAST(ls_chunk_arena_get_span(chunk_arena, (dir_size + chunk_arena->_chunk_size - 1) / chunk_arena->_chunk_size, status), ls_u64_p *);
+
+	if (buddy._tree_a)
+	{
+		LS_MEMSET(buddy._tree_a, 0, dir_size);
+	}
+
+	LS_MEMSET(buddy._free_a, 0, sizeof(buddy._free_a));
+
+	return buddy;
+}
+
+static LS_INLINE void ls_buddy_fini(ls_buddy_s *buddy)
+{
+	ls_u64_t chunk_i;
+
+	for (chunk_i = 0; buddy->_tree_c; chunk_i++)
+	{
+		if (buddy->_tree_a[chunk_i])
+		{
+			ls_chunk_arena_delete_chunk(buddy->_chunk_arena, LS_CHUNK_ARENA_INDEX_TO_ADDR(buddy->_chunk_arena, chunk_i));
+			buddy->_tree_c--;
+		}
+	}
+
+	ls_object_pool_fini(&buddy->_tree_pool);
+	ls_chunk_arena_delete_span(buddy->_chunk_arena, buddy->_tree_a);
+}
+
+
+static LS_INLINE ls_void_p ls_buddy_alloc(ls_buddy_s *buddy, ls_u64_t size, ls_result_t *status)
+{
+	ls_u64_t order = (size <= LS_BUDDY_MIN_BLOCK_SIZE) ? 0 : LS_CEIL_LOG2(size) - LS_FLOOR_LOG2(LS_BUDDY_MIN_BLOCK_SIZE);
+	ls_u64_t from;
+	ls_u8_p  block_p;
+	ls_u64_p tree;
+	ls_u64_t offset;
+
+	if (order >= buddy->_order_c)
+	{
+		*status = LS_BUDDY_TOO_LARGE;
+		return LS_NULL;
+	}
+
+	for (from = order; from < buddy->_order_c && !buddy->_free_a[from]; from++);
+
+	if (from == buddy->_order_c)
+	{
+		if (!_ls_buddy_grow(buddy, status))
+		{
+			return LS_NULL;
+		}
+
+		from--;
+	}
+	else
+	{
+		*status = LS_SUCCESS;
+	}
+
+	block_p	= LS_CAST(buddy->_free_a[from], ls_u8_p);
+	tree	= buddy->_tree_a[LS_CHUNK_ARENA_ADDR_TO_INDEX(buddy->_chunk_arena, block_p)];
+	offset	= LS_CAST(block_p, ls_u64_t) & (buddy->_chunk_arena->_chunk_size - 1);
+
+	_ls_buddy_unlink(buddy, block_p, from);
+	LS_BUDDY_BIT_CLEAR(tree, LS_BUDDY_NODE(buddy, offset, from));
+
+	/* split down to [order], keeping the lower half and freeing the upper one */
+	while (from > order)
+	{
+		LS_BUDDY_BIT_SET(tree + buddy->_word_c, LS_BUDDY_NODE(buddy, offset, from));
+		from--;
+
+		_ls_buddy_push(buddy, block_p + (LS_CAST(LS_BUDDY_MIN_BLOCK_SIZE, ls_u64_t) << from), from);
+		LS_BUDDY_BIT_SET(tree, LS_BUDDY_NODE(buddy, offset, from) + 1);
+	}
+
+	return block_p;
+}
+
+static LS_INLINE void ls_buddy_free(ls_buddy_s *buddy, ls_void_p block_p)
+{
+	ls_u64_t  chunk_i	= LS_CHUNK_ARENA_ADDR_TO_INDEX(buddy->_chunk_arena, block_p);
+	ls_u8_p	  chunk_p	= LS_CAST(LS_CHUNK_ARENA_INDEX_TO_ADDR(buddy->_chunk_arena, chunk_i), ls_u8_p);
+	ls_u64_p  tree		= buddy->_tree_a[chunk_i];
+	ls_u64_t  offset	= LS_CAST(block_p, ls_u8_p) - chunk_p;
+	ls_u64_t  order		= _ls_buddy_find(buddy, tree, offset);
+	ls_u64_t  node		= LS_BUDDY_NODE(buddy, offset, order);
+
+	/* merge with the buddy for as long as it is free as a whole */
+	while (order + 1 < buddy->_order_c && LS_BUDDY_BIT_GET(tree, node ^ 1))
+	{
+		ls_u64_t buddy_offset = offset ^ (LS_CAST(LS_BUDDY_MIN_BLOCK_SIZE, ls_u64_t) << order);
+
+		_ls_buddy_unlink(buddy, chunk_p + buddy_offset, order);
+		LS_BUDDY_BIT_CLEAR(tree, node ^ 1);
+
+		offset	= offset & buddy_offset;
+		node	= node >> 1;
+		order++;
+
+		LS_BUDDY_BIT_CLEAR(tree + buddy->_word_c, node);
+	}
+
+	if (order + 1 == buddy->_order_c && buddy->_tree_c > 1)
+	{
+		buddy->_tree_a[chunk_i] = LS_CAST(LS_NULL, ls_u64_p);
+		buddy->_tree_c--;
+
+		ls_object_pool_free(&buddy->_tree_pool, tree);
+		ls_chunk_arena_delete_chunk(buddy->_chunk_arena, chunk_p);
+
+		return;
+	}
+
+	_ls_buddy_push(buddy, chunk_p + offset, order);
+	LS_BUDDY_BIT_SET(tree, node);
+}
+
+static LS_INLINE ls_u64_t ls_buddy_block_size(ls_buddy_s *buddy, ls_void_p block_p)
+{
+	ls_u64_p tree	= buddy->_tree_a[LS_CHUNK_ARENA_ADDR_TO_INDEX(buddy->_chunk_arena, block_p)];
+	ls_u64_t offset	= LS_CAST(block_p, ls_u64_t) & (buddy->_chunk_arena->_chunk_size - 1);
+
+	return LS_CAST(LS_BUDDY_MIN_BLOCK_SIZE, ls_u64_t) << _ls_buddy_find(buddy, tree, offset);
+}
+
+
+/* returns the order of the block in use at [offset]: the first one down from the root that is not split */
+static LS_INLINE ls_u64_t _ls_buddy_find(ls_buddy_s *buddy, ls_u64_p tree, ls_u64_t offset)
+{
+	ls_u64_t order = buddy->_order_c - 1;
+
+	while (order && LS_BUDDY_BIT_GET(tree + buddy->_word_c, LS_BUDDY_NODE(buddy, offset, order)))
+	{
+		order--;
+	}
+
+	return order;
+}
+
+/* takes a chunk from the arena as a new tree, free as a whole */
+static LS_INLINE ls_bool_t _ls_buddy_grow(ls_buddy_s *buddy, ls_result_t *status)
+{
+	ls_u64_p  tree;
+	ls_void_p chunk_p;
+
+	tree = LS_CAST(ls_object_pool_alloc(&buddy->_tree_pool, status), ls_u64_p);
+
+	if (!tree)
+	{
+		return LS_FALSE;
+	}
+
+	chunk_p = ls_chunk_arena_get_chunk(buddy->_chunk_arena, status);
+
+	if (!chunk_p)
+	{
+		ls_object_pool_free(&buddy->_tree_pool, tree);
+		return LS_FALSE;
+	}
+
+	LS_MEMSET(tree, 0, buddy->_tree_pool._slot_size);
+	LS_BUDDY_BIT_SET(tree, 1);
+
+	buddy->_tree_a[LS_CHUNK_ARENA_ADDR_TO_INDEX(buddy->_chunk_arena, chunk_p)] = tree;
+	buddy->_tree_c++;
+
+	_ls_buddy_push(buddy, chunk_p, buddy->_order_c - 1);
+
+	return LS_TRUE;
+}
+
+static LS_INLINE void _ls_buddy_push(ls_buddy_s *buddy, ls_void_p block_p, ls_u64_t order)
+{
+	ls_buddy_block_s *block = LS_CAST(block_p, ls_buddy_block_s *);
+
+	block->_prev = LS_CAST(LS_NULL, ls_buddy_block_s *);
+	block->_next = buddy->_free_a[order];
+
+	if (block->_next)
+	{
+		block->_next->_prev = block;
+	}
+
+	buddy->_free_a[order] = block;
+}
+
+static LS_INLINE void _ls_buddy_unlink(ls_buddy_s *buddy, ls_void_p block_p, ls_u64_t order)
+{
+	ls_buddy_block_s *block = LS_CAST(block_p, ls_buddy_block_s *);
+
+	if (block->_prev)
+	{
+		block->_prev->_next = block->_next;
+	}
+	else
+	{
+		buddy->_free_a[order] = block->_next;
+	}
+
+	if (block->_next)
+	{
+		block->_next->_prev = block->_prev;
+	}
+}
+
+
+#endif  /* #ifndef LS_BUDDY_H */
+
+
+/*
+ * Copyright (C) 2025  Logan Seeley
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
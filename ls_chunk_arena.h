@@ -1,5 +1,5 @@
 /*
- * ls_chunk_arena.h - v1.0.3 - chunk arena allocator - Logan Seeley 2025
+ * ls_chunk_arena.h - v1.16.0 - chunk arena allocator - Logan Seeley 2025
  *
  * Documentation
  *
@@ -9,9 +9,20 @@
  *		The lifetime of any [ls_chunk_arena_s] must be less than
  *		that of the memory provided to it.
  *
- *		The arena does not free deleted chunks; it tries to reuse
- *		them. Meaning this allocator does not work well with
- *		programs that fluctuate greatly with memory usage.
+ *		The arena does not free deleted chunks on its own; it tries
+ *		to reuse them. Call [ls_chunk_arena_trim] to give memory of
+ *		deleted chunks back after usage spikes.
+ *
+ *		An arena holds at most 2^32 - 1 chunks.
+ *
+ *		The free list lives in a metadata array of 20 bytes per chunk
+ *		carved from the end of the memory, so deleting or reviving a
+ *		chunk never touches the chunk itself, and trimmed chunks stay
+ *		fully decommitted until handed out again.
+ *
+ *		Functions suffixed with _atomic may be called from any
+ *		amount of threads at once, the others need the arena to
+ *		be locked. Both kinds must not be used at the same time.
  *
  *	Usage
  *
@@ -21,15 +32,43 @@
  *		commit function provided by your allocator **before**
  *		including this file.
  *
+ *		Optionally, define [_ls_chunk_arena_alloca_decommit_range]
+ *		to the decommit function of your allocator for
+ *		[ls_chunk_arena_trim] to release memory. It must only
+ *		decommit whole pages inside the range it is given
+ *		(e.g. ls_valloc_pfree_range).
+ *
+ *		Or define LS_CHUNK_ARENA_USE_VALLOC instead to bind both to
+ *		ls_valloc.h, which also enables self-growing arenas (see below).
+ *
  *	Functions
  *
  * 		ls_chunk_arena_s ls_chunk_arena_init(ls_void_p memory, ls_u64_t memory_size, ls_u64_t chunk_size) - arena_init
  *			[memory] must be aligned to [chunk_size]
  *			and by divisible by such. [chunk_size]
- *			must be a power of 2.
+ *			must be a power of 2 of at least 32.
+ *			Every chunk costs [chunk_size] + 20 bytes, the
+ *			metadata sits right past the last chunk: the arena
+ *			holds [memory_size] / ([chunk_size] + 20) chunks,
+ *			76% of the memory at 64 byte chunks, 99.5% at 4K.
+ *
+ *		ls_chunk_arena_s ls_chunk_arena_init_ordered(ls_void_p memory, ls_u64_t memory_size, ls_u64_t chunk_size) - arena_init_ordered
+ *			same as [ls_chunk_arena_init], but deleted chunks are tracked in a
+ *			hierarchical bitmap instead of the free stack and [ls_chunk_arena_get_chunk]
+ *			always hands out the lowest free chunk. This keeps the live chunks dense
+ *			and in address order, so [ls_chunk_arena_trim] can release more of the end.
+ *			A get or delete costs one bit scan per level (at most 6).
+ *			Only the non _atomic functions may be used on such an arena, no magazines.
+ *			The bitmap takes 1 bit per chunk (plus 1/64 of that per level above)
+ *			at the end of the memory and is committed and cleared here.
  *
  *		void ls_chunk_arena_fini(ls_chunk_arena_s *chunk_arena) - arena_fini
  *
+ *		void ls_chunk_arena_set_commit_ahead(ls_chunk_arena_s *chunk_arena, ls_u64_t chunk_c, ls_u64_t byte_c) - arena_set_commit_ahead
+ *			Fresh chunks are committed [chunk_c] chunks or [byte_c] bytes at a time,
+ *			whichever is more, so [_ls_chunk_arena_alloca_commit_range] is called
+ *			once per window instead of once per chunk. Defaults to 1 chunk.
+ *
  *		ls_void_p ls_chunk_arena_get_chunk(ls_chunk_arena_s *chunk_arena, ls_u32_t *status) - arena_get_chunk
  *			[status] is out
  *			[*status] = LS_SUCCESS
@@ -37,6 +76,292 @@
  *
  *		void ls_chunk_arena_delete_chunk(ls_chunk_arena_s *chunk_arena, ls_void_p chunk_p) - arena_delete_chunk
  *			[chunk_p] must have been returned by [ls_chunk_arena_get_chunk]
+ *
+ *		void ls_chunk_arena_get_chunks(ls_chunk_arena_s *chunk_arena, ls_u64_t chunk_c, ls_void_p *chunk_a, ls_u32_t *status) - arena_get_chunks
+ *			[chunk_a] is out, fills [chunk_a] with [chunk_c] chunks at once:
+ *			deleted chunks are popped off in one run, then free spans are
+ *			split, the rest is carved from fresh chunks with at most one commit call.
+ *			Trimmed chunks next to each other are committed again together.
+ *			[status] is out
+ *			[*status] = LS_SUCCESS
+ *			[*status] = LS_CHUNK_ARENA_MEM_FULL -> fewer than [chunk_c] chunks left, none were fetched
+ *
+ *		void ls_chunk_arena_delete_chunks(ls_chunk_arena_s *chunk_arena, ls_void_p const *chunk_a, ls_u64_t chunk_c) - arena_delete_chunks
+ *			deletes the [chunk_c] chunks of [chunk_a], pushed onto the free list in one step.
+ *			[chunk_a] must hold chunks returned by [ls_chunk_arena_get_chunk] or [ls_chunk_arena_get_chunks]
+ *
+ *		ls_void_p ls_chunk_arena_get_span(ls_chunk_arena_s *chunk_arena, ls_u64_t chunk_c, ls_u32_t *status) - arena_get_span
+ *			returns [chunk_c] adjacent chunks. Free spans are kept in bins by
+ *			length class and the first fitting one is split, otherwise the span
+ *			is carved from fresh chunks. [ls_chunk_arena_get_chunk] takes single
+ *			chunks off free spans before carving fresh ones.
+ *			[status] is out
+ *			[*status] = LS_SUCCESS
+ *			[*status] = LS_CHUNK_ARENA_MEM_FULL -> no [chunk_c] adjacent chunks left. [return] will also be LS_NULL
+ *
+ *		void ls_chunk_arena_delete_span(ls_chunk_arena_s *chunk_arena, ls_void_p span_p) - arena_delete_span
+ *			[span_p] must have been returned by [ls_chunk_arena_get_span].
+ *			The span is merged with free spans right before and after it.
+ *			Single deleted chunks are not merged into spans.
+ *
+ *		void ls_chunk_arena_reset(ls_chunk_arena_s *chunk_arena, ls_bool_t decommit) - arena_reset
+ *			deletes every chunk and span at once, retired ones included, and closes every scope.
+ *			With [decommit] every committed chunk is given back to the
+ *			allocator, otherwise it is kept committed to be handed out again.
+ *			Magazines must be empty (flushed or re-initialized) afterwards.
+ *
+ *		void ls_chunk_arena_trim(ls_chunk_arena_s *chunk_arena, ls_u64_t idle_c) - arena_trim
+ *			Decommits deleted chunks at the end of the arena, lowering
+ *			[_next_committed_chunk], along with any window committed ahead.
+ *			Other deleted chunks are decommitted whole once they stayed
+ *			deleted for more than [idle_c] calls of this function,
+ *			adjacent ones in a single call. Chunks smaller than a page
+ *			are only released once the whole page is decommitted.
+ *			Call it periodically.
+ *			Free spans are released the same way.
+ *			Chunks held by magazines or the depot are left alone.
+ *			Must not run at the same time as any other arena function.
+ *
+ *		ls_void_p ls_chunk_arena_get_chunk_atomic(ls_chunk_arena_s *chunk_arena, ls_u32_t *status) - arena_get_chunk_atomic
+ *			lock-free [ls_chunk_arena_get_chunk]
+ *			[_ls_chunk_arena_alloca_commit_range] must be thread-safe.
+ *
+ *		void ls_chunk_arena_delete_chunk_atomic(ls_chunk_arena_s *chunk_arena, ls_void_p chunk_p) - arena_delete_chunk_atomic
+ *			lock-free [ls_chunk_arena_delete_chunk]
+ *
+ *	Iteration & Compaction
+ *
+ *		ls_chunk_arena_iter_s ls_chunk_arena_iter_init(void) - arena_iter_init
+ *
+ *		ls_void_p ls_chunk_arena_iter_next(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_iter_s *iter, ls_u64_t *chunk_c) - arena_iter_next
+ *			returns the next live chunk or span in address order, LS_NULL once done.
+ *			[chunk_c] is out: 1 for a chunk, the length of a span otherwise.
+ *			Chunks held by magazines or the depot, and chunks deleted inside
+ *			an open scope, count as live.
+ *
+ *		ls_u64_t ls_chunk_arena_compact(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_move_fn move_fn, ls_void_p user) - arena_compact
+ *			moves live chunks and spans from the top of the arena into the
+ *			lowest free chunks below, then trims what was freed at the top.
+ *			A span only moves into enough adjacent free chunks; compaction stops
+ *			at the first chunk or span that cannot move down.
+ *			[move_fn] is called after each move so owners can update references.
+ *			Free chunks below the new top are rebuilt into spans where adjacent,
+ *			except in ordered arenas, where they stay in the bitmap.
+ *			Returns the amount of chunks moved. Does nothing (returns 0) while a
+ *			scope is open or limbo lists hold retired chunks; flush magazines
+ *			and reclaim limbo lists first. Batches in the depot are deleted
+ *			chunks like any other and are compacted over.
+ *
+ *		typedef void (*ls_chunk_arena_move_fn)(ls_void_p from, ls_void_p to, ls_u64_t chunk_c, ls_void_p user);
+ *
+ *	Handles
+ *
+ *		A handle is a 32-bit reference to a chunk or span: its 1-based index in the
+ *		low 32 - LS_CHUNK_ARENA_HANDLE_GEN_BITS bits, and in the high bits the
+ *		generation of the chunk, which every delete bumps. Resolving a handle of a
+ *		deleted chunk fails, until the generation wraps around. Handles only cover
+ *		arenas of less than 2^(32 - LS_CHUNK_ARENA_HANDLE_GEN_BITS) chunks.
+ *		Chunks dropped by [ls_chunk_arena_reset] or [ls_chunk_arena_restore] fail
+ *		to resolve as well: handing out a chunk that was not reused from a delete
+ *		bumps its generation too, and metadata is never decommitted.
+ *
+ *		ls_chunk_arena_handle_t ls_chunk_arena_handle(ls_chunk_arena_s *chunk_arena, ls_void_p chunk_p) - arena_handle
+ *			returns LS_CHUNK_ARENA_NULL_HANDLE if [chunk_p] lies past what handles can index
+ *
+ *		ls_void_p ls_chunk_arena_resolve(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_handle_t handle) - arena_resolve
+ *			returns LS_NULL if [handle] is LS_CHUNK_ARENA_NULL_HANDLE or its chunk was deleted since.
+ *			A check against use after delete, not a way to synchronize threads.
+ *
+ *	Scopes
+ *
+ *		A checkpoint opens a scope: until it is restored, chunks and spans are
+ *		only carved fresh past the checkpoint, and deleting any chunk handed out
+ *		inside an open scope does nothing. Restoring then drops everything handed
+ *		out since the checkpoint in O(1), as if it all was deleted. Scopes nest
+ *		and must be restored in reverse order. Chunks handed out before the
+ *		outermost checkpoint are deleted as usual, but not reused until it is
+ *		restored. Only the non _atomic functions may be used while a scope is open.
+ *
+ *		ls_chunk_arena_checkpoint_s ls_chunk_arena_checkpoint(ls_chunk_arena_s *chunk_arena) - arena_checkpoint
+ *
+ *		void ls_chunk_arena_restore(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_checkpoint_s checkpoint) - arena_restore
+ *			[checkpoint] must be the innermost open one.
+ *			Trimmed in between chunks stay decommitted, the rest stays committed.
+ *
+ *	Magazines
+ *
+ *		A magazine is a small per-thread stack of chunks in front of the
+ *		_atomic functions. Gets and deletes that hit the magazine touch no
+ *		shared state; otherwise whole batches of LS_CHUNK_ARENA_MAGAZINE_SIZE
+ *		chunks are exchanged with the arena's depot in a single operation.
+ *		When the depot is empty, an empty magazine is refilled whole under a
+ *		single reservation, from the free stack and then fresh chunks.
+ *		Chunks held by magazines count as used by the arena, batches in the
+ *		depot do not: the non _atomic gets move them onto the free stack
+ *		before carving fresh chunks, so a flushed arena can be used locked.
+ *
+ *		ls_chunk_arena_magazine_s ls_chunk_arena_magazine_init(void) - magazine_init
+ *			the magazine must only be used by one thread, e.g. make it _Thread_local.
+ *
+ *		ls_void_p ls_chunk_arena_magazine_get_chunk(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_magazine_s *magazine, ls_u32_t *status) - magazine_get_chunk
+ *			same as [ls_chunk_arena_get_chunk_atomic]
+ *
+ *		void ls_chunk_arena_magazine_delete_chunk(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_magazine_s *magazine, ls_void_p chunk_p) - magazine_delete_chunk
+ *			[chunk_p] must have been returned by [ls_chunk_arena_magazine_get_chunk] or [ls_chunk_arena_get_chunk_atomic]
+ *
+ *		void ls_chunk_arena_magazine_flush(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_magazine_s *magazine) - magazine_flush
+ *			returns every chunk held by [magazine] to the arena, call before the thread exits.
+ *
+ *	Epochs
+ *
+ *		Chunks of lock-free structures cannot be deleted while other threads may
+ *		still read them. Threads read such chunks only inside critical sections,
+ *		and retire chunks instead of deleting them. A retired chunk sits on a
+ *		limbo list of the retiring thread (chained through the metadata, the chunk
+ *		is not touched) until the global epoch advanced twice, by then no critical
+ *		section that could have seen it is left. The epoch advances once every
+ *		thread inside a critical section has entered it in the current epoch.
+ *		Every LS_CHUNK_ARENA_EPOCH_PERIOD retires and gets of a thread, it tries
+ *		to advance the epoch and hands its safe limbo lists back to the arena,
+ *		each in a single operation. Retired chunks count as used by the arena.
+ *		Critical sections do not nest.
+ *
+ *		void ls_chunk_arena_epoch_register(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_epoch_s *epoch) - epoch_register
+ *			[epoch] must only be used by one thread at a time and stays registered
+ *			for the lifetime of [chunk_arena], so it must live at least as long.
+ *			Hand it over to a new thread instead of registering one per thread.
+ *
+ *		void ls_chunk_arena_epoch_enter(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_epoch_s *epoch) - epoch_enter
+ *
+ *		void ls_chunk_arena_epoch_exit(ls_chunk_arena_epoch_s *epoch) - epoch_exit
+ *
+ *		void ls_chunk_arena_epoch_retire(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_epoch_s *epoch, ls_void_p chunk_p) - epoch_retire
+ *			[chunk_p] must have been returned by [ls_chunk_arena_get_chunk_atomic] or [ls_chunk_arena_epoch_get_chunk]
+ *			and be unreachable for critical sections entered from now on.
+ *
+ *		ls_void_p ls_chunk_arena_epoch_get_chunk(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_epoch_s *epoch, ls_u32_t *status) - epoch_get_chunk
+ *			same as [ls_chunk_arena_get_chunk_atomic], when the arena is full
+ *			the epoch is advanced and the limbo lists of [epoch] are reclaimed
+ *			if possible before trying again.
+ *
+ *		void ls_chunk_arena_epoch_reclaim(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_epoch_s *epoch) - epoch_reclaim
+ *			tries to advance the epoch and hands back every limbo list of [epoch]
+ *			that is safe. Call it until they are empty before the thread exits.
+ *
+ *	Statistics
+ *
+ *		The arena keeps totals of chunks got and deleted and of calls to
+ *		[_ls_chunk_arena_alloca_commit_range] since init; reset and restore do
+ *		not clear them. Magazines count the batches they exchange with the
+ *		arena, not every get and delete they serve, and retired chunks count
+ *		once reclaimed. Define LS_CHUNK_ARENA_NO_STATS to drop the counting.
+ *
+ *		void ls_chunk_arena_stats(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_stats_s *stats) - arena_stats
+ *			O(1), may be called from any thread at any time for sampling.
+ *			[stats->fragmentation] is the share of committed chunks that sit
+ *			free below the high water mark, deleted but not reused yet.
+ *
+ *	Families
+ *
+ *		A family manages chunks of several sizes inside one memory block. The
+ *		block is run as an arena of the largest size, and each smaller size
+ *		carves its chunks out of such blocks, taken one at a time as needed.
+ *		A block whose chunks are all deleted goes back at once, to be taken
+ *		by any size, so memory moves to whichever size is in demand without
+ *		a call. The bookkeeping of every block and the links of deleted chunks
+ *		are kept out of band, past the blocks' metadata, so every chunk of a
+ *		carved block is handed out and never written to while deleted; only
+ *		whole free blocks are decommitted by trimming.
+ *		Like the non _atomic functions, a family must be locked.
+ *
+ *		void ls_chunk_arena_family_init(ls_chunk_arena_family_s *family, ls_void_p memory, ls_u64_t memory_size, ls_u64_t const *chunk_size_a, ls_u64_t class_c) - family_init
+ *			[chunk_size_a] holds [class_c] (at most LS_CHUNK_ARENA_CLASS_MAX_C) distinct chunk
+ *			sizes in ascending order, each a power of 2 of at least 32, the largest
+ *			below 2^32 times the smallest. [memory] must be aligned to the largest of them.
+ *			Every block costs the largest size + 44 bytes, plus a 4 byte link per chunk
+ *			of the smallest size it could be carved into, committed once carved.
+ *
+ *		void ls_chunk_arena_family_fini(ls_chunk_arena_family_s *family) - family_fini
+ *
+ *		ls_void_p ls_chunk_arena_family_get_chunk(ls_chunk_arena_family_s *family, ls_u64_t size, ls_u32_t *status) - family_get_chunk
+ *			returns a chunk of the smallest size of at least [size] bytes.
+ *			[status] is out
+ *			[*status] = LS_SUCCESS
+ *			[*status] = LS_CHUNK_ARENA_MEM_FULL -> no block is left for that size. [return] will also be LS_NULL
+ *			[*status] = LS_CHUNK_ARENA_TOO_LARGE -> [size] is above the largest chunk size. [return] will also be LS_NULL
+ *
+ *		void ls_chunk_arena_family_delete_chunk(ls_chunk_arena_family_s *family, ls_void_p chunk_p) - family_delete_chunk
+ *			[chunk_p] must have been returned by [ls_chunk_arena_family_get_chunk]
+ *
+ *		ls_u64_t ls_chunk_arena_family_chunk_size(ls_chunk_arena_family_s *family, ls_void_p chunk_p) - family_chunk_size
+ *			the size of the chunk [chunk_p] points to.
+ *
+ *		void ls_chunk_arena_family_trim(ls_chunk_arena_family_s *family, ls_u64_t idle_c) - family_trim
+ *			[ls_chunk_arena_trim] on the blocks, e.g. from an ls_valloc reclaim callback.
+ *
+ *	NUMA
+ *
+ *		A NUMA arena splits one memory block into an equal region per node, each
+ *		run by its own arena. Before anything is committed each region is bound
+ *		to its node with mbind (preferred, not strict), so the pages of a chunk
+ *		are faulted in on the node that owns it. Gets take a chunk of the node
+ *		the calling thread runs on, and deletes go back to the node the chunk
+ *		belongs to, found by the region its address lies in. Only Linux binds
+ *		memory and queries the node, elsewhere every thread is on node 0.
+ *		With strict C standards on Linux, _GNU_SOURCE must be defined at
+ *		compile time for these system calls.
+ *		Like the _atomic functions, any amount of threads may use it at once.
+ *
+ *		Define LS_CHUNK_ARENA_NUMA_NODE() to return the node of the calling
+ *		thread differently, e.g. a cached thread local instead of a system call,
+ *		or a simulated topology on a single node host.
+ *
+ *		void ls_chunk_arena_numa_init(ls_chunk_arena_numa_s *numa, ls_void_p memory, ls_u64_t memory_size, ls_u64_t chunk_size, ls_u64_t node_c) - numa_init
+ *			[node_c] nodes, clamped to [1, LS_CHUNK_ARENA_NUMA_MAX_NODE_C]. [memory] must
+ *			be aligned to [chunk_size] and to the page size for regions to be bound.
+ *			Regions are sized to whole chunks and whole pages, so no page is shared by two.
+ *
+ *		void ls_chunk_arena_numa_fini(ls_chunk_arena_numa_s *numa) - numa_fini
+ *
+ *		ls_void_p ls_chunk_arena_numa_get_chunk(ls_chunk_arena_numa_s *numa, ls_u32_t *status) - numa_get_chunk
+ *			falls back to the other nodes once the region of the caller's node is full.
+ *			[status] is out
+ *			[*status] = LS_SUCCESS
+ *			[*status] = LS_CHUNK_ARENA_MEM_FULL -> every region is full. [return] will also be LS_NULL
+ *
+ *		void ls_chunk_arena_numa_delete_chunk(ls_chunk_arena_numa_s *numa, ls_void_p chunk_p) - numa_delete_chunk
+ *			[chunk_p] must have been returned by [ls_chunk_arena_numa_get_chunk]
+ *
+ *		ls_u64_t ls_chunk_arena_numa_node_of(ls_chunk_arena_numa_s *numa, ls_void_p chunk_p) - numa_node_of
+ *
+ *	Self-growing Arenas
+ *
+ *		Only with LS_CHUNK_ARENA_USE_VALLOC. A self-growing arena reserves its
+ *		own memory with [ls_valloc_vmalloc], as much address space as there is
+ *		physical memory. When that segment is full, another one is reserved and
+ *		chained, up to LS_CHUNK_ARENA_SEGMENT_MAX_C. Segments are never extended
+ *		in place, as the metadata sits at the end of each. Gets take the lowest
+ *		segment with a chunk left. Like the non _atomic functions, a self-growing
+ *		arena must be locked.
+ *
+ *		ls_result_t ls_chunk_arena_grow_init(ls_chunk_arena_grow_s *grow, ls_u64_t chunk_size) - grow_init
+ *			[chunk_size] must be a power of 2 of at least 32, a multiple of the
+ *			page size for trimming to release memory.
+ *			Returns LS_FAIL if the first segment could not be reserved.
+ *
+ *		void ls_chunk_arena_grow_fini(ls_chunk_arena_grow_s *grow) - grow_fini
+ *			unreserves every segment.
+ *
+ *		ls_void_p ls_chunk_arena_grow_get_chunk(ls_chunk_arena_grow_s *grow, ls_u32_t *status) - grow_get_chunk
+ *			[status] is out
+ *			[*status] = LS_SUCCESS
+ *			[*status] = LS_CHUNK_ARENA_MEM_FULL -> no segment could be added. [return] will also be LS_NULL
+ *
+ *		void ls_chunk_arena_grow_delete_chunk(ls_chunk_arena_grow_s *grow, ls_void_p chunk_p) - grow_delete_chunk
+ *			[chunk_p] must have been returned by [ls_chunk_arena_grow_get_chunk]
+ *
+ *		void ls_chunk_arena_grow_trim(ls_chunk_arena_grow_s *grow, ls_u64_t idle_c) - grow_trim
+ *			[ls_chunk_arena_trim] on every segment.
  */
 
 
@@ -46,8 +371,26 @@
 
 #include "./ls_macros.h"
 
+#ifdef __linux__
+	#include <unistd.h>
+	#include <sys/syscall.h>
+#endif
+
 
-#define LS_CHUNK_ARENA_MEM_FULL	2
+#define LS_CHUNK_ARENA_MEM_FULL		2
+#define LS_CHUNK_ARENA_TOO_LARGE	3
+
+
+#ifdef LS_CHUNK_ARENA_USE_VALLOC
+	#ifdef _ls_chunk_arena_alloca_commit_range
+		#error "LS_CHUNK_ARENA_USE_VALLOC brings its own allocator binding"
+	#endif
+
+	#include "./ls_valloc.h"
+
+	#define _ls_chunk_arena_alloca_commit_range(memory, offset, range)		ls_valloc_pcommit_range(memory, offset, range)
+	#define _ls_chunk_arena_alloca_decommit_range(memory, offset, range)	ls_valloc_pfree_range(memory, offset, range)
+#endif
 
 
 /* 
@@ -60,31 +403,370 @@
     #error "chunk arena is missing allocator binding"
 #endif
 
+#ifndef _ls_chunk_arena_alloca_decommit_range
+    #define _ls_chunk_arena_alloca_decommit_range(memory, offset, range)  /* memory is never released */
+#endif
+
 
 #define LS_CHUNK_ARENA_INDEX_TO_ADDR(chunk_arena, index) (LS_CAST((index) * chunk_arena->_chunk_size + LS_CAST(chunk_arena->_memory, ls_u64_t), ls_void_p))
 #define LS_CHUNK_ARENA_ADDR_TO_INDEX(chunk_arena, ptr) ((LS_CAST(ptr, ls_u64_t) - LS_CAST(chunk_arena->_memory, ls_u64_t)) / chunk_arena->_chunk_size)
 
+#define LS_CHUNK_ARENA_META_OFFSET(chunk_arena, index) ((chunk_arena)->_max_chunk_c * (chunk_arena)->_chunk_size + (index) * sizeof(ls_chunk_arena_meta_s))
+#define _LS_CHUNK_ARENA_BITMAP_OFFSET(chunk_c, chunk_size) LS_ROUND_UP_TO((chunk_c) * ((chunk_size) + sizeof(ls_chunk_arena_meta_s)), sizeof(ls_u64_t))
+
+#define LS_CHUNK_ARENA_MAX_CHUNK_C	0xFFFFFFFFllu
+
+/*
+ * [_last_deleted_chunk] packs the 1-based index of the top free chunk in its
+ * low 32 bits, and a tag bumped on every change in its high 32 bits so
+ * lock-free pops cannot be fooled by a chunk that was popped and pushed back (ABA)
+ */
+#define LS_CHUNK_ARENA_FREE_INDEX(word)			((word) & 0xFFFFFFFFllu)
+#define LS_CHUNK_ARENA_FREE_TAG(word)			((word) >> 32)
+#define LS_CHUNK_ARENA_FREE_WORD(index, tag)	(LS_CAST(index, ls_u64_t) | (LS_CAST(tag, ls_u64_t) << 32))
+
+/* [_flags] of ls_chunk_arena_meta_s */
+#define LS_CHUNK_ARENA_FREE			(1u << 0)  /* on the free stack */
+#define LS_CHUNK_ARENA_DECOMMITTED	(1u << 1)  /* released by ls_chunk_arena_trim */
+#define LS_CHUNK_ARENA_SPAN_FREE	(1u << 2)  /* first or last chunk of a free span */
+#define LS_CHUNK_ARENA_SPAN			(1u << 3)  /* first or last chunk of a span handed out */
+#define LS_CHUNK_ARENA_TRIMMED		(1u << 4)  /* decommitted by the running ls_chunk_arena_trim, not yet released */
+
+#define LS_CHUNK_ARENA_SPAN_BIN_C	32  /* bin i holds free spans of [2^i, 2^(i + 1)) chunks */
+
+#ifndef LS_CHUNK_ARENA_HANDLE_GEN_BITS
+	#define LS_CHUNK_ARENA_HANDLE_GEN_BITS	8  /* 24-bit indices, 16M chunks */
+#endif
+
+#if LS_CHUNK_ARENA_HANDLE_GEN_BITS < 1 || LS_CHUNK_ARENA_HANDLE_GEN_BITS > 24
+	#error "LS_CHUNK_ARENA_HANDLE_GEN_BITS must be in [1, 24]"
+#endif
+
+#define LS_CHUNK_ARENA_NULL_HANDLE			0
+#define LS_CHUNK_ARENA_HANDLE_INDEX_BITS	(32 - LS_CHUNK_ARENA_HANDLE_GEN_BITS)
+#define LS_CHUNK_ARENA_HANDLE_INDEX_MASK	((1u << LS_CHUNK_ARENA_HANDLE_INDEX_BITS) - 1)
+#define LS_CHUNK_ARENA_HANDLE_GEN_MASK		((1u << LS_CHUNK_ARENA_HANDLE_GEN_BITS) - 1)
+
+#define LS_CHUNK_ARENA_BITMAP_MAX_DEPTH	6  /* 64^6 > LS_CHUNK_ARENA_MAX_CHUNK_C */
+
+#ifndef LS_CHUNK_ARENA_MAGAZINE_SIZE
+	#define LS_CHUNK_ARENA_MAGAZINE_SIZE	32  /* chunks exchanged with the depot at once */
+#endif
+
+#ifndef LS_CHUNK_ARENA_EPOCH_PERIOD
+	#define LS_CHUNK_ARENA_EPOCH_PERIOD		64  /* retires and gets of a thread between reclaim attempts */
+#endif
+
+#define LS_CHUNK_ARENA_EPOCH_LIMBO_C	3  /* limbo lists of epochs e - 2, e - 1 and e */
+
+#ifndef LS_CHUNK_ARENA_CLASS_MAX_C
+	#define LS_CHUNK_ARENA_CLASS_MAX_C		8  /* chunk sizes of an arena family */
+#endif
+
+#ifndef LS_CHUNK_ARENA_NUMA_MAX_NODE_C
+	#define LS_CHUNK_ARENA_NUMA_MAX_NODE_C	8
+#endif
+
+/* node of the calling thread, define it to e.g. a cached thread local or a simulated topology */
+#ifndef LS_CHUNK_ARENA_NUMA_NODE
+	#define LS_CHUNK_ARENA_NUMA_NODE()		_ls_chunk_arena_numa_node()
+#endif
+
+#ifndef LS_CHUNK_ARENA_SEGMENT_MAX_C
+	#define LS_CHUNK_ARENA_SEGMENT_MAX_C	16  /* segments of a self-growing arena, each reserves physical memory size */
+#endif
+
+/* define LS_CHUNK_ARENA_NO_STATS to leave the counters of ls_chunk_arena_stats at 0 */
+#ifndef LS_CHUNK_ARENA_NO_STATS
+	#define _LS_CHUNK_ARENA_COUNT(chunk_arena, counter, n)			((chunk_arena)->counter += (n))
+	#define _LS_CHUNK_ARENA_COUNT_ATOMIC(chunk_arena, counter, n)	__atomic_fetch_add(&(chunk_arena)->counter, (n), __ATOMIC_RELAXED)
+#else
+	#define _LS_CHUNK_ARENA_COUNT(chunk_arena, counter, n)			((void) 0)
+	#define _LS_CHUNK_ARENA_COUNT_ATOMIC(chunk_arena, counter, n)	((void) 0)
+#endif
+
+/* every call of the commit binding goes through here to be counted, from any thread */
+#define _LS_CHUNK_ARENA_COMMIT(chunk_arena, offset, range)											\
+	do																								\
+	{																								\
+		_LS_CHUNK_ARENA_COUNT_ATOMIC(chunk_arena, _commit_call_c, 1);								\
+		_ls_chunk_arena_alloca_commit_range((chunk_arena)->_memory, offset, range);					\
+	}																								\
+	while (0)
+
+
+/*
+ * out of band state of one chunk, committed along with the chunk. a depot batch head is never
+ * the first chunk of a free span, so both link through [_link]; [_trim_c] is only read while free
+ */
+typedef struct
+{
+	ls_u32_t	_next;		/* 1-based index of the next chunk on the free stack, in a depot batch or on a limbo list */
+	ls_u32_t	_link;		/* first chunk of a depot batch: the next batch, first chunk of a free span: the previous span in its bin, 1-based */
+	ls_u32_t	_trim_c;	/* trim count the chunk was deleted at */
+	ls_u32_t	_span_c;	/* first and last chunk of a span: its length */
+	ls_u32_t	_flags	: 8;
+	ls_u32_t	_gen	: 24;  /* bumped on every delete, checked by handles */
+}
+ls_chunk_arena_meta_s;
+
+
+typedef ls_u32_t ls_chunk_arena_handle_t;
+
 
 typedef struct
 {
     ls_void_p	_memory;
+	ls_chunk_arena_meta_s *_meta;  /* one entry per chunk, right past the last chunk */
 
     ls_u64_t	_max_chunk_c;
 	ls_u64_t	_chunk_size;
 	ls_u64_t	_chunk_c;
 
 	ls_u64_t	_next_committed_chunk;
+	ls_u64_t	_committed_chunk_c;  /* chunks [0, _committed_chunk_c) are committed */
+	ls_u64_t	_commit_ahead_c;
 	ls_u64_t	_last_deleted_chunk;
+	ls_u64_t	_trim_c;
+
+	/*
+	 * stack of full batches, packed like [_last_deleted_chunk]. the chunks of a batch
+	 * are chained through [_next], its first chunk holds the next batch in [_batch].
+	 * depot chunks do not count in [_chunk_c]
+	 */
+	ls_u64_t	_depot;
+
+	/*
+	 * ordered arenas only: bit i of level 0 is set when chunk i is deleted, bit i of
+	 * level l > 0 when word i of level l - 1 is not 0. level [_bitmap_depth] - 1 is a single word
+	 */
+	ls_u64_p	_bitmap;
+	ls_u64_t	_bitmap_depth;
+	ls_u64_t	_bitmap_level_a[LS_CHUNK_ARENA_BITMAP_MAX_DEPTH];  /* word offset of each level into [_bitmap] */
+
+	ls_u32_t	_span_bin_a[LS_CHUNK_ARENA_SPAN_BIN_C];  /* 1-based index of the first free span of each bin */
+
+	/* chunks [_scope_floor, _next_committed_chunk - 1) were handed out in a scope and are dropped on restore */
+	ls_u64_t	_scope_c;
+	ls_u64_t	_scope_floor;
+
+	ls_u64_t	_epoch;
+	struct ls_chunk_arena_epoch_s *_epoch_list;  /* registered threads, never shrinks */
+
+	/* totals since init, see ls_chunk_arena_stats */
+	ls_u64_t	_get_c;
+	ls_u64_t	_delete_c;
+	ls_u64_t	_commit_call_c;
 }
 ls_chunk_arena_s;
 
 
+typedef struct
+{
+	ls_u64_t	_mark;  /* [_next_committed_chunk] when it was taken */
+}
+ls_chunk_arena_checkpoint_s;
+
+
+typedef struct
+{
+	ls_u64_t	_chunk_i;
+}
+ls_chunk_arena_iter_s;
+
+
+typedef void (*ls_chunk_arena_move_fn)(ls_void_p from, ls_void_p to, ls_u64_t chunk_c, ls_void_p user);
+
+
+typedef struct
+{
+	ls_u32_t	_round_c;
+	ls_u32_t	_round_a[LS_CHUNK_ARENA_MAGAZINE_SIZE * 2];  /* 1-based chunk indices */
+}
+ls_chunk_arena_magazine_s;
+
+
+typedef struct ls_chunk_arena_epoch_s
+{
+	struct ls_chunk_arena_epoch_s *_next;
+
+	ls_u64_t	_local;  /* epoch the critical section was entered in << 1 | 1, 0 outside of one */
+	ls_u64_t	_op_c;
+
+	/* list i holds chunks retired in epoch [_limbo_epoch_a[i]], chained through [_next] */
+	ls_u64_t	_limbo_epoch_a[LS_CHUNK_ARENA_EPOCH_LIMBO_C];
+	ls_u32_t	_limbo_a[LS_CHUNK_ARENA_EPOCH_LIMBO_C];  /* 1-based index of the first chunk */
+	ls_u32_t	_limbo_last_a[LS_CHUNK_ARENA_EPOCH_LIMBO_C];
+}
+ls_chunk_arena_epoch_s;
+
+
+typedef struct
+{
+	ls_u64_t	live_c;			/* chunks used, including those held by magazines and limbo lists */
+	ls_u64_t	high_water_c;	/* chunks [0, high_water_c) were handed out at some point */
+	ls_u64_t	committed_c;	/* chunks committed, some may have been trimmed since */
+	ls_u64_t	free_c;			/* chunks below [high_water_c] waiting to be reused */
+	ls_u64_t	get_c;
+	ls_u64_t	delete_c;
+	ls_u64_t	commit_call_c;
+	ls_f64_t	fragmentation;	/* [free_c] / [committed_c], 0 if nothing is committed */
+}
+ls_chunk_arena_stats_s;
+
+
+/* bookkeeping of a block handed out by a family, kept out of band */
+typedef struct
+{
+	ls_u32_t	_class_i;
+	ls_u32_t	_used_c;	/* chunks handed out */
+	ls_u32_t	_free_i;	/* last deleted chunk, 1-based, the next is in its link, 0 if none */
+	ls_u32_t	_bump_i;	/* first chunk never handed out */
+	ls_u32_t	_prev;		/* blocks of the class with chunks left, 1-based */
+	ls_u32_t	_next;
+}
+ls_chunk_arena_block_s;
+
+
+typedef struct
+{
+	ls_chunk_arena_s	_block;  /* chunks of the largest size, the others are carved from them */
+	ls_chunk_arena_block_s *_block_meta;  /* per block, past the metadata of [_block] */
+	ls_u32_p			_link_a;  /* per block [_slot_c] links of deleted chunks, 1-based */
+	ls_u64_t			_slot_c;  /* chunks of the smallest size in a block */
+
+	ls_u64_t			_chunk_size_a[LS_CHUNK_ARENA_CLASS_MAX_C];  /* ascending */
+	ls_u32_t			_partial_a[LS_CHUNK_ARENA_CLASS_MAX_C];  /* first block of each class with chunks left, 1-based, 0 if none */
+	ls_u64_t			_class_c;
+}
+ls_chunk_arena_family_s;
+
+
+typedef struct
+{
+	ls_chunk_arena_s	_node_a[LS_CHUNK_ARENA_NUMA_MAX_NODE_C];  /* node i owns region i */
+
+	ls_void_p			_memory;
+	ls_u64_t			_region_size;
+	ls_u64_t			_node_c;
+}
+ls_chunk_arena_numa_s;
+
+
+#ifdef LS_CHUNK_ARENA_USE_VALLOC
+
+typedef struct
+{
+	ls_chunk_arena_s	_segment_a[LS_CHUNK_ARENA_SEGMENT_MAX_C];
+	ls_void_p			_reserve_a[LS_CHUNK_ARENA_SEGMENT_MAX_C];  /* as returned by ls_valloc_vmalloc, [_memory] is aligned up from it */
+
+	ls_u64_t			_segment_c;
+	ls_u64_t			_chunk_size;
+	ls_u64_t			_hint;  /* no segment below it has a chunk left */
+}
+ls_chunk_arena_grow_s;
+
+#endif
+
+
 static ls_chunk_arena_s ls_chunk_arena_init							(ls_void_p			 memory, 		ls_u64_t 		memory_size, 	ls_u64_t 	chunk_size) LS_LIBFN;
+static ls_chunk_arena_s ls_chunk_arena_init_ordered					(ls_void_p			 memory, 		ls_u64_t 		memory_size, 	ls_u64_t 	chunk_size) LS_LIBFN;
+static ls_u64_t			_ls_chunk_arena_bitmap_layout				(ls_u64_t			 chunk_c, 		ls_u64_t	   *level_a, 		ls_u64_p	depth)		LS_LIBFN;
 static void				ls_chunk_arena_fini							(ls_chunk_arena_s 	*chunk_arena) 															LS_LIBFN;
+static void				ls_chunk_arena_set_commit_ahead				(ls_chunk_arena_s 	*chunk_arena, 	ls_u64_t 		chunk_c, 		ls_u64_t 	byte_c)		LS_LIBFN;
+static void				_ls_chunk_arena_commit_to					(ls_chunk_arena_s 	*chunk_arena, 	ls_u64_t 		chunk_i)								LS_LIBFN;
+static void				_ls_chunk_arena_commit_to_atomic			(ls_chunk_arena_s 	*chunk_arena, 	ls_u64_t 		chunk_i)								LS_LIBFN;
 
 static ls_void_p 		ls_chunk_arena_get_chunk					(ls_chunk_arena_s   *chunk_arena, 	ls_result_t    *status)									LS_LIBFN;
 static ls_void_p 		_ls_chunk_arena_revive_last_deleted_chunk	(ls_chunk_arena_s 	*chunk_arena) 															LS_LIBFN;
 static void				ls_chunk_arena_delete_chunk					(ls_chunk_arena_s 	*chunk_arena, 	ls_void_p 		chunk_p)								LS_LIBFN;
+static void				_ls_chunk_arena_recommit					(ls_chunk_arena_s 	*chunk_arena, 	ls_u64_t 		chunk_i)								LS_LIBFN;
+static void				_ls_chunk_arena_recommit_fresh				(ls_chunk_arena_s 	*chunk_arena, 	ls_u64_t 		chunk_i)								LS_LIBFN;
+
+static void				ls_chunk_arena_get_chunks					(ls_chunk_arena_s 	*chunk_arena, 	ls_u64_t 		chunk_c, 		ls_void_p  *chunk_a, 	ls_result_t *status)	LS_LIBFN;
+static void				ls_chunk_arena_delete_chunks				(ls_chunk_arena_s 	*chunk_arena, 	ls_void_p const *chunk_a, 		ls_u64_t 	chunk_c)				LS_LIBFN;
+
+static ls_void_p 		ls_chunk_arena_get_span						(ls_chunk_arena_s   *chunk_arena, 	ls_u64_t 		chunk_c, 		ls_result_t *status)	LS_LIBFN;
+static void				ls_chunk_arena_delete_span					(ls_chunk_arena_s 	*chunk_arena, 	ls_void_p 		span_p)									LS_LIBFN;
+static ls_u64_t			_ls_chunk_arena_span_find					(ls_chunk_arena_s 	*chunk_arena, 	ls_u64_t 		chunk_c)								LS_LIBFN;
+static ls_void_p		_ls_chunk_arena_span_take					(ls_chunk_arena_s 	*chunk_arena, 	ls_u64_t 		chunk_i, 		ls_u64_t 	chunk_c)	LS_LIBFN;
+static void				_ls_chunk_arena_span_push					(ls_chunk_arena_s 	*chunk_arena, 	ls_u64_t 		chunk_i, 		ls_u64_t 	chunk_c,	ls_u32_t flags)	LS_LIBFN;
+static void				_ls_chunk_arena_span_unlink					(ls_chunk_arena_s 	*chunk_arena, 	ls_u64_t 		chunk_i)								LS_LIBFN;
+static void				_ls_chunk_arena_span_tag					(ls_chunk_arena_s 	*chunk_arena, 	ls_u64_t 		chunk_i, 		ls_u64_t 	chunk_c)	LS_LIBFN;
+
+static ls_chunk_arena_handle_t ls_chunk_arena_handle				(ls_chunk_arena_s 	*chunk_arena, 	ls_void_p 		chunk_p)								LS_LIBFN;
+static ls_void_p		ls_chunk_arena_resolve						(ls_chunk_arena_s 	*chunk_arena, 	ls_chunk_arena_handle_t handle)							LS_LIBFN;
+
+static ls_chunk_arena_iter_s ls_chunk_arena_iter_init				(void)																					LS_LIBFN;
+static ls_void_p		ls_chunk_arena_iter_next					(ls_chunk_arena_s 	*chunk_arena, 	ls_chunk_arena_iter_s *iter, 	ls_u64_p 	chunk_c)	LS_LIBFN;
+static ls_u64_t			ls_chunk_arena_compact						(ls_chunk_arena_s 	*chunk_arena, 	ls_chunk_arena_move_fn move_fn, ls_void_p 	user)		LS_LIBFN;
+static ls_u64_t			_ls_chunk_arena_compact_free_run			(ls_chunk_arena_s 	*chunk_arena, 	ls_u64_t 		chunk_i, 		ls_u64_t 	end)		LS_LIBFN;
+static void				_ls_chunk_arena_compact_rebuild				(ls_chunk_arena_s 	*chunk_arena, 	ls_u64_t 		top)									LS_LIBFN;
+
+static ls_u64_t			_ls_chunk_arena_bitmap_lowest				(ls_chunk_arena_s 	*chunk_arena)															LS_LIBFN;
+static void				_ls_chunk_arena_bitmap_set					(ls_chunk_arena_s 	*chunk_arena, 	ls_u64_t 		chunk_i)								LS_LIBFN;
+static void				_ls_chunk_arena_bitmap_clear				(ls_chunk_arena_s 	*chunk_arena, 	ls_u64_t 		chunk_i)								LS_LIBFN;
+
+static void				ls_chunk_arena_reset						(ls_chunk_arena_s 	*chunk_arena, 	ls_bool_t 		decommit)								LS_LIBFN;
+static ls_chunk_arena_checkpoint_s ls_chunk_arena_checkpoint		(ls_chunk_arena_s 	*chunk_arena)															LS_LIBFN;
+static void				ls_chunk_arena_restore						(ls_chunk_arena_s 	*chunk_arena, 	ls_chunk_arena_checkpoint_s checkpoint)					LS_LIBFN;
+static ls_bool_t		_ls_chunk_arena_scope_drop					(ls_chunk_arena_s 	*chunk_arena, 	ls_u64_t 		chunk_i)								LS_LIBFN;
+
+static void				ls_chunk_arena_trim							(ls_chunk_arena_s 	*chunk_arena, 	ls_u64_t 		idle_c)									LS_LIBFN;
+static ls_bool_t		_ls_chunk_arena_trim_chunk					(ls_chunk_arena_s 	*chunk_arena, 	ls_u64_t 		chunk_i, 		ls_u64_t 	idle_c)		LS_LIBFN;
+static void				_ls_chunk_arena_trim_release				(ls_chunk_arena_s 	*chunk_arena, 	ls_u64_t 		top)									LS_LIBFN;
+
+static ls_void_p 		ls_chunk_arena_get_chunk_atomic				(ls_chunk_arena_s   *chunk_arena, 	ls_result_t    *status)									LS_LIBFN;
+static void				ls_chunk_arena_delete_chunk_atomic			(ls_chunk_arena_s 	*chunk_arena, 	ls_void_p 		chunk_p)								LS_LIBFN;
+static ls_u64_t			_ls_chunk_arena_take_atomic					(ls_chunk_arena_s 	*chunk_arena)															LS_LIBFN;
+static ls_u64_t			_ls_chunk_arena_pop_atomic					(ls_chunk_arena_s 	*chunk_arena)															LS_LIBFN;
+static ls_u64_t			_ls_chunk_arena_bump_atomic					(ls_chunk_arena_s 	*chunk_arena, 	ls_u64_t 		chunk_c, 		ls_u64_p 	chunk_i)	LS_LIBFN;
+static ls_u64_t			_ls_chunk_arena_depot_take					(ls_chunk_arena_s 	*chunk_arena)															LS_LIBFN;
+static void				_ls_chunk_arena_depot_give					(ls_chunk_arena_s 	*chunk_arena, 	ls_u32_t const *round_a)								LS_LIBFN;
+static void				_ls_chunk_arena_depot_drain					(ls_chunk_arena_s 	*chunk_arena)															LS_LIBFN;
+
+static ls_chunk_arena_magazine_s ls_chunk_arena_magazine_init		(void)																					LS_LIBFN;
+static ls_void_p 		ls_chunk_arena_magazine_get_chunk			(ls_chunk_arena_s   *chunk_arena, 	ls_chunk_arena_magazine_s *magazine, ls_result_t *status)	LS_LIBFN;
+static void				ls_chunk_arena_magazine_delete_chunk		(ls_chunk_arena_s 	*chunk_arena, 	ls_chunk_arena_magazine_s *magazine, ls_void_p chunk_p)		LS_LIBFN;
+static void				ls_chunk_arena_magazine_flush				(ls_chunk_arena_s 	*chunk_arena, 	ls_chunk_arena_magazine_s *magazine)						LS_LIBFN;
+
+static void				ls_chunk_arena_epoch_register				(ls_chunk_arena_s 	*chunk_arena, 	ls_chunk_arena_epoch_s *epoch)								LS_LIBFN;
+static void				ls_chunk_arena_epoch_enter					(ls_chunk_arena_s 	*chunk_arena, 	ls_chunk_arena_epoch_s *epoch)								LS_LIBFN;
+static void				ls_chunk_arena_epoch_exit					(ls_chunk_arena_epoch_s *epoch)																LS_LIBFN;
+static void				ls_chunk_arena_epoch_retire					(ls_chunk_arena_s 	*chunk_arena, 	ls_chunk_arena_epoch_s *epoch, 	ls_void_p 	chunk_p)		LS_LIBFN;
+static ls_void_p 		ls_chunk_arena_epoch_get_chunk				(ls_chunk_arena_s   *chunk_arena, 	ls_chunk_arena_epoch_s *epoch, 	ls_result_t *status)		LS_LIBFN;
+static void				ls_chunk_arena_epoch_reclaim				(ls_chunk_arena_s 	*chunk_arena, 	ls_chunk_arena_epoch_s *epoch)								LS_LIBFN;
+static void				_ls_chunk_arena_epoch_free					(ls_chunk_arena_s 	*chunk_arena, 	ls_chunk_arena_epoch_s *epoch, 	ls_u64_t 	limbo_i)		LS_LIBFN;
+static ls_bool_t		_ls_chunk_arena_epoch_pending				(ls_chunk_arena_s 	*chunk_arena)															LS_LIBFN;
+
+static void				ls_chunk_arena_stats						(ls_chunk_arena_s 	*chunk_arena, 	ls_chunk_arena_stats_s *stats)								LS_LIBFN;
+
+static void				ls_chunk_arena_family_init					(ls_chunk_arena_family_s *family, ls_void_p		memory, 		ls_u64_t 	memory_size, 	ls_u64_t const *chunk_size_a, 	ls_u64_t class_c)	LS_LIBFN;
+static void				ls_chunk_arena_family_fini					(ls_chunk_arena_family_s *family)															LS_LIBFN;
+static ls_void_p 		ls_chunk_arena_family_get_chunk				(ls_chunk_arena_family_s *family, ls_u64_t 		size, 			ls_result_t *status)	LS_LIBFN;
+static void				ls_chunk_arena_family_delete_chunk			(ls_chunk_arena_family_s *family, ls_void_p 		chunk_p)								LS_LIBFN;
+static ls_u64_t			ls_chunk_arena_family_chunk_size			(ls_chunk_arena_family_s *family, ls_void_p 		chunk_p)								LS_LIBFN;
+static void				ls_chunk_arena_family_trim					(ls_chunk_arena_family_s *family, ls_u64_t 		idle_c)									LS_LIBFN;
+static ls_u64_t			_ls_chunk_arena_family_class				(ls_chunk_arena_family_s *family, ls_u64_t 		size)									LS_LIBFN;
+static ls_chunk_arena_block_s *_ls_chunk_arena_family_block			(ls_chunk_arena_family_s *family, ls_u64_t 		block_i)								LS_LIBFN;
+static void				_ls_chunk_arena_family_unlink				(ls_chunk_arena_family_s *family, ls_u64_t 		block_i)								LS_LIBFN;
+
+static void				ls_chunk_arena_numa_init					(ls_chunk_arena_numa_s *numa, 	ls_void_p		memory, 		ls_u64_t 	memory_size, 	ls_u64_t chunk_size, 	ls_u64_t node_c)	LS_LIBFN;
+static void				ls_chunk_arena_numa_fini					(ls_chunk_arena_numa_s *numa)																LS_LIBFN;
+static ls_void_p 		ls_chunk_arena_numa_get_chunk				(ls_chunk_arena_numa_s *numa, 	ls_result_t    *status)									LS_LIBFN;
+static void				ls_chunk_arena_numa_delete_chunk			(ls_chunk_arena_numa_s *numa, 	ls_void_p 		chunk_p)								LS_LIBFN;
+static ls_u64_t			ls_chunk_arena_numa_node_of					(ls_chunk_arena_numa_s *numa, 	ls_void_p 		chunk_p)								LS_LIBFN;
+static ls_u64_t			_ls_chunk_arena_numa_node					(void)																					LS_LIBFN;
+static void				_ls_chunk_arena_numa_bind					(ls_void_p			 memory, 		ls_u64_t 		size, 			ls_u64_t 	node)		LS_LIBFN;
+
+#ifdef LS_CHUNK_ARENA_USE_VALLOC
+	static ls_result_t		ls_chunk_arena_grow_init					(ls_chunk_arena_grow_s *grow, 	ls_u64_t 		chunk_size)								LS_LIBFN;
+	static void				ls_chunk_arena_grow_fini					(ls_chunk_arena_grow_s *grow)																LS_LIBFN;
+	static ls_void_p 		ls_chunk_arena_grow_get_chunk				(ls_chunk_arena_grow_s *grow, 	ls_result_t    *status)									LS_LIBFN;
+	static void				ls_chunk_arena_grow_delete_chunk			(ls_chunk_arena_grow_s *grow, 	ls_void_p 		chunk_p)								LS_LIBFN;
+	static void				ls_chunk_arena_grow_trim					(ls_chunk_arena_grow_s *grow, 	ls_u64_t 		idle_c)									LS_LIBFN;
+	static ls_result_t		_ls_chunk_arena_grow_segment				(ls_chunk_arena_grow_s *grow)																LS_LIBFN;
+#endif
 
 
 static LS_INLINE ls_chunk_arena_s ls_chunk_arena_init(ls_void_p memory, ls_u64_t memory_size, ls_u64_t chunk_size)
@@ -93,81 +775,2197 @@ static LS_INLINE ls_chunk_arena_s ls_chunk_arena_init(ls_void_p memory, ls_u64_t
 
     chunk_arena._memory        			= memory;
 
-    chunk_arena._max_chunk_c   			= memory_size / chunk_size;
+	/* the metadata starts right past the last chunk, each chunk costs its size and its metadata */
+    chunk_arena._max_chunk_c   			= memory_size / (chunk_size + sizeof(ls_chunk_arena_meta_s));
+	chunk_arena._max_chunk_c			= (chunk_arena._max_chunk_c > LS_CHUNK_ARENA_MAX_CHUNK_C) ? LS_CHUNK_ARENA_MAX_CHUNK_C : chunk_arena._max_chunk_c;
+	chunk_arena._meta					= LS_CAST(LS_CAST(memory, ls_u8_p) + chunk_arena._max_chunk_c * chunk_size, ls_chunk_arena_meta_s *);
 	chunk_arena._chunk_size				= chunk_size;
 	chunk_arena._chunk_c				= 0;
 
 	chunk_arena._next_committed_chunk 	= 1;
+	chunk_arena._committed_chunk_c		= 0;
+	chunk_arena._commit_ahead_c			= 1;
 	chunk_arena._last_deleted_chunk		= 0;
+	chunk_arena._trim_c					= 0;
+	chunk_arena._depot					= 0;
+
+	chunk_arena._bitmap					= LS_CAST(LS_NULL, ls_u64_p);
+	chunk_arena._bitmap_depth			= 0;
+
+	LS_MEMSET(chunk_arena._span_bin_a, 0, sizeof(chunk_arena._span_bin_a));
+
+	chunk_arena._scope_c				= 0;
+	chunk_arena._scope_floor			= 0;
+
+	chunk_arena._epoch					= 0;
+	chunk_arena._epoch_list				= LS_CAST(LS_NULL, ls_chunk_arena_epoch_s *);
+
+	chunk_arena._get_c					= 0;
+	chunk_arena._delete_c				= 0;
+	chunk_arena._commit_call_c			= 0;
 
     return chunk_arena;
 }
 
+static LS_INLINE ls_chunk_arena_s ls_chunk_arena_init_ordered(ls_void_p memory, ls_u64_t memory_size, ls_u64_t chunk_size)
+{
+	ls_chunk_arena_s chunk_arena	= ls_chunk_arena_init(memory, memory_size, chunk_size);
+	ls_u64_t per_chunk_size			= chunk_size + sizeof(ls_chunk_arena_meta_s);
+	ls_u64_t chunk_c				= chunk_arena._max_chunk_c;
+	ls_u64_t need_size;
+	ls_u64_t word_c;
+
+	/* the bitmap comes on top, dropping a chunk frees at least its size and its metadata */
+	while (chunk_c && (need_size = _LS_CHUNK_ARENA_BITMAP_OFFSET(chunk_c, chunk_size) + _ls_chunk_arena_bitmap_layout(chunk_c,
+		chunk_arena._bitmap_level_a, &chunk_arena._bitmap_depth) * sizeof(ls_u64_t)) > memory_size)
+	{
+		need_size	= (need_size - memory_size + per_chunk_size - 1) / per_chunk_size;
+		chunk_c		= (need_size < chunk_c) ? chunk_c - need_size : 0;
+	}
+
+	chunk_arena._max_chunk_c	= chunk_c;
+	chunk_arena._meta			= LS_CAST(LS_CAST(memory, ls_u8_p) + chunk_arena._max_chunk_c * chunk_size, ls_chunk_arena_meta_s *);
+	chunk_arena._bitmap			= LS_CAST(LS_CAST(memory, ls_u8_p) + _LS_CHUNK_ARENA_BITMAP_OFFSET(chunk_arena._max_chunk_c, chunk_size), ls_u64_p);
+
+	word_c = _ls_chunk_arena_bitmap_layout(chunk_arena._max_chunk_c, chunk_arena._bitmap_level_a, &chunk_arena._bitmap_depth);
+
+	_LS_CHUNK_ARENA_COMMIT(&chunk_arena, _LS_CHUNK_ARENA_BITMAP_OFFSET(chunk_arena._max_chunk_c, chunk_size), word_c * sizeof(ls_u64_t));
+	LS_MEMSET(chunk_arena._bitmap, 0, word_c * sizeof(ls_u64_t));
+
+	return chunk_arena;
+}
+
+/* fills in the word offset of each level for [chunk_c] chunks, returns the total amount of words */
+static LS_INLINE ls_u64_t _ls_chunk_arena_bitmap_layout(ls_u64_t chunk_c, ls_u64_t *level_a, ls_u64_p depth)
+{
+	ls_u64_t word_c = 0;
+	ls_u64_t level_word_c;
+
+	*depth = 0;
+
+	do
+	{
+		level_word_c		= (chunk_c + 63) / 64;
+		level_word_c		= level_word_c ? level_word_c : 1;
+		level_a[(*depth)++]	= word_c;
+		word_c			   += level_word_c;
+		chunk_c				= level_word_c;
+	}
+	while (level_word_c > 1);
+
+	return word_c;
+}
+
 static LS_INLINE void ls_chunk_arena_fini(ls_chunk_arena_s *chunk_arena)
 {
     chunk_arena->_memory        		= LS_NULL;
+	chunk_arena->_meta					= LS_CAST(LS_NULL, ls_chunk_arena_meta_s *);
 
 	chunk_arena->_max_chunk_c   		= 0;
 	chunk_arena->_chunk_size			= 0;
 	chunk_arena->_chunk_c				= 0;
 	
 	chunk_arena->_next_committed_chunk 	= 0;
+	chunk_arena->_committed_chunk_c		= 0;
+	chunk_arena->_commit_ahead_c		= 0;
 	chunk_arena->_last_deleted_chunk	= 0;
+	chunk_arena->_trim_c				= 0;
+	chunk_arena->_depot					= 0;
+
+	chunk_arena->_bitmap				= LS_CAST(LS_NULL, ls_u64_p);
+	chunk_arena->_bitmap_depth			= 0;
+
+	LS_MEMSET(chunk_arena->_span_bin_a, 0, sizeof(chunk_arena->_span_bin_a));
+
+	chunk_arena->_scope_c				= 0;
+	chunk_arena->_scope_floor			= 0;
+
+	chunk_arena->_epoch					= 0;
+	chunk_arena->_epoch_list			= LS_CAST(LS_NULL, ls_chunk_arena_epoch_s *);
+
+	chunk_arena->_get_c					= 0;
+	chunk_arena->_delete_c				= 0;
+	chunk_arena->_commit_call_c			= 0;
 }
 
 
-static LS_INLINE ls_void_p ls_chunk_arena_get_chunk(ls_chunk_arena_s *chunk_arena, ls_result_t *status)
+static LS_INLINE void ls_chunk_arena_set_commit_ahead(ls_chunk_arena_s *chunk_arena, ls_u64_t chunk_c, ls_u64_t byte_c)
 {
-	if (chunk_arena->_max_chunk_c == chunk_arena->_chunk_c)
-	{
-		*status = LS_CHUNK_ARENA_MEM_FULL;
-		return LS_NULL;
-	}
-	else
-	{
-		*status = LS_SUCCESS;
-	}
+	byte_c = (byte_c + chunk_arena->_chunk_size - 1) / chunk_arena->_chunk_size;
+	chunk_c = (byte_c > chunk_c) ? byte_c : chunk_c;
 
-	chunk_arena->_chunk_c++;
-	
-	if (!chunk_arena->_last_deleted_chunk)
-	{
-		ls_void_p chunk_p = LS_CHUNK_ARENA_INDEX_TO_ADDR(chunk_arena, chunk_arena->_next_committed_chunk - 1);
-		_ls_chunk_arena_alloca_commit_range(chunk_arena->_memory, (chunk_arena->_next_committed_chunk - 1) * chunk_arena->_chunk_size, chunk_arena->_chunk_size);
+	chunk_arena->_commit_ahead_c = (chunk_c == 0) ? 1 : chunk_c;
+}
 
-		chunk_arena->_next_committed_chunk++;
+/* makes sure chunk [chunk_i] and its metadata are committed, committing a whole window past it if not */
+static LS_INLINE void _ls_chunk_arena_commit_to(ls_chunk_arena_s *chunk_arena, ls_u64_t chunk_i)
+{
+	ls_u64_t end;
 
-		return chunk_p;
-	}
-	else
+	if (chunk_i < chunk_arena->_committed_chunk_c)
 	{
-		return _ls_chunk_arena_revive_last_deleted_chunk(chunk_arena);
+		return;
 	}
+
+	end = chunk_i + chunk_arena->_commit_ahead_c;
+	end = (end > chunk_arena->_max_chunk_c) ? chunk_arena->_max_chunk_c : end;
+
+	_LS_CHUNK_ARENA_COMMIT(chunk_arena, chunk_arena->_committed_chunk_c * chunk_arena->_chunk_size,
+		(end - chunk_arena->_committed_chunk_c) * chunk_arena->_chunk_size);
+	_LS_CHUNK_ARENA_COMMIT(chunk_arena, LS_CHUNK_ARENA_META_OFFSET(chunk_arena, chunk_arena->_committed_chunk_c),
+		(end - chunk_arena->_committed_chunk_c) * sizeof(ls_chunk_arena_meta_s));
+
+	chunk_arena->_committed_chunk_c = end;
 }
 
-static LS_INLINE ls_void_p _ls_chunk_arena_revive_last_deleted_chunk(ls_chunk_arena_s *chunk_arena)
+/*
+ * threads racing for the same window may commit overlapping ranges, which is harmless.
+ * the window end is only published once committed
+ */
+static LS_INLINE void _ls_chunk_arena_commit_to_atomic(ls_chunk_arena_s *chunk_arena, ls_u64_t chunk_i)
 {
-	ls_u64_p deleted_chunk = LS_CAST(LS_CHUNK_ARENA_INDEX_TO_ADDR(chunk_arena, chunk_arena->_last_deleted_chunk - 1), ls_u64_p);
+	ls_u64_t committed_c = __atomic_load_n(&chunk_arena->_committed_chunk_c, __ATOMIC_ACQUIRE);
+	ls_u64_t end;
 
-	chunk_arena->_last_deleted_chunk = deleted_chunk[0];
+	while (chunk_i >= committed_c)
+	{
+		end = chunk_i + __atomic_load_n(&chunk_arena->_commit_ahead_c, __ATOMIC_RELAXED);
+		end = (end > chunk_arena->_max_chunk_c) ? chunk_arena->_max_chunk_c : end;
+
+		_LS_CHUNK_ARENA_COMMIT(chunk_arena, committed_c * chunk_arena->_chunk_size,
+			(end - committed_c) * chunk_arena->_chunk_size);
+		_LS_CHUNK_ARENA_COMMIT(chunk_arena, LS_CHUNK_ARENA_META_OFFSET(chunk_arena, committed_c),
+			(end - committed_c) * sizeof(ls_chunk_arena_meta_s));
 
-	return deleted_chunk;
+		if (__atomic_compare_exchange_n(&chunk_arena->_committed_chunk_c, &committed_c, end, 0, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE))
+		{
+			return;
+		}
+	}
 }
 
 
-static LS_INLINE void ls_chunk_arena_delete_chunk(ls_chunk_arena_s *chunk_arena, ls_void_p chunk_p)
+static LS_INLINE ls_void_p ls_chunk_arena_get_chunk(ls_chunk_arena_s *chunk_arena, ls_result_t *status)
+{
+	ls_u64_t chunk_i;
+	ls_u64_t span_i;
+
+	if (!chunk_arena->_scope_c && LS_CHUNK_ARENA_FREE_INDEX(chunk_arena->_depot) && !LS_CHUNK_ARENA_FREE_INDEX(chunk_arena->_last_deleted_chunk))
+	{
+		_ls_chunk_arena_depot_drain(chunk_arena);
+	}
+
+	if (chunk_arena->_max_chunk_c == chunk_arena->_chunk_c)
+	{
+		*status = LS_CHUNK_ARENA_MEM_FULL;
+		return LS_NULL;
+	}
+
+	if (!chunk_arena->_scope_c && chunk_arena->_bitmap_depth && chunk_arena->_bitmap[chunk_arena->_bitmap_level_a[chunk_arena->_bitmap_depth - 1]])
+	{
+		chunk_i = _ls_chunk_arena_bitmap_lowest(chunk_arena);
+
+		_ls_chunk_arena_bitmap_clear(chunk_arena, chunk_i);
+		_ls_chunk_arena_recommit(chunk_arena, chunk_i);
+	}
+	else if (!chunk_arena->_scope_c && LS_CHUNK_ARENA_FREE_INDEX(chunk_arena->_last_deleted_chunk))
+	{
+		chunk_i = LS_CHUNK_ARENA_ADDR_TO_INDEX(chunk_arena, _ls_chunk_arena_revive_last_deleted_chunk(chunk_arena));
+	}
+	else if (!chunk_arena->_scope_c && (span_i = _ls_chunk_arena_span_find(chunk_arena, 1)))
+	{
+		chunk_i = LS_CHUNK_ARENA_ADDR_TO_INDEX(chunk_arena, _ls_chunk_arena_span_take(chunk_arena, span_i - 1, 1));
+	}
+	else if (chunk_arena->_next_committed_chunk <= chunk_arena->_max_chunk_c)
+	{
+		chunk_i = chunk_arena->_next_committed_chunk - 1;
+
+		_ls_chunk_arena_commit_to(chunk_arena, chunk_i);
+		_ls_chunk_arena_recommit_fresh(chunk_arena, chunk_i);
+
+		chunk_arena->_next_committed_chunk++;
+	}
+	else
+	{
+		/* the rest is held by magazines or deleted below an open scope, past the last chunk lies the metadata */
+		*status = LS_CHUNK_ARENA_MEM_FULL;
+		return LS_NULL;
+	}
+
+	*status = LS_SUCCESS;
+
+	chunk_arena->_chunk_c++;
+	_LS_CHUNK_ARENA_COUNT(chunk_arena, _get_c, 1);
+
+	return LS_CHUNK_ARENA_INDEX_TO_ADDR(chunk_arena, chunk_i);
+}
+
+static LS_INLINE ls_void_p _ls_chunk_arena_revive_last_deleted_chunk(ls_chunk_arena_s *chunk_arena)
+{
+	ls_u64_t head	 = chunk_arena->_last_deleted_chunk;
+	ls_u64_t chunk_i = LS_CHUNK_ARENA_FREE_INDEX(head) - 1;
+
+	chunk_arena->_last_deleted_chunk = LS_CHUNK_ARENA_FREE_WORD(chunk_arena->_meta[chunk_i]._next, LS_CHUNK_ARENA_FREE_TAG(head) + 1);
+
+	_ls_chunk_arena_recommit(chunk_arena, chunk_i);
+
+	return LS_CHUNK_ARENA_INDEX_TO_ADDR(chunk_arena, chunk_i);
+}
+
+
+static LS_INLINE void ls_chunk_arena_delete_chunk(ls_chunk_arena_s *chunk_arena, ls_void_p chunk_p)
 {
 	ls_u64_t chunk_i;
 	
 	chunk_i = LS_CHUNK_ARENA_ADDR_TO_INDEX(chunk_arena, chunk_p);
 
-	LS_CAST(chunk_p, ls_u64_p)[0] = chunk_arena->_last_deleted_chunk;
+	chunk_arena->_meta[chunk_i]._gen++;
+	_LS_CHUNK_ARENA_COUNT(chunk_arena, _delete_c, 1);
+
+	if (_ls_chunk_arena_scope_drop(chunk_arena, chunk_i))
+	{
+		return;
+	}
 
-	chunk_arena->_last_deleted_chunk = chunk_i + 1;
+	chunk_arena->_meta[chunk_i]._trim_c	= LS_CAST(chunk_arena->_trim_c, ls_u32_t);
+	chunk_arena->_meta[chunk_i]._flags	= LS_CHUNK_ARENA_FREE;
 	chunk_arena->_chunk_c--;
+
+	if (chunk_arena->_bitmap_depth)
+	{
+		_ls_chunk_arena_bitmap_set(chunk_arena, chunk_i);
+		return;
+	}
+
+	chunk_arena->_meta[chunk_i]._next	= LS_CAST(LS_CHUNK_ARENA_FREE_INDEX(chunk_arena->_last_deleted_chunk), ls_u32_t);
+
+	chunk_arena->_last_deleted_chunk = LS_CHUNK_ARENA_FREE_WORD(chunk_i + 1, LS_CHUNK_ARENA_FREE_TAG(chunk_arena->_last_deleted_chunk) + 1);
+}
+
+/* marks a revived or fresh chunk as used, committing it again if it was trimmed */
+static LS_INLINE void _ls_chunk_arena_recommit(ls_chunk_arena_s *chunk_arena, ls_u64_t chunk_i)
+{
+	if (chunk_arena->_meta[chunk_i]._flags & LS_CHUNK_ARENA_DECOMMITTED)
+	{
+		_LS_CHUNK_ARENA_COMMIT(chunk_arena, chunk_i * chunk_arena->_chunk_size, chunk_arena->_chunk_size);
+	}
+
+	chunk_arena->_meta[chunk_i]._flags = 0;
+}
+
+/*
+ * marks a chunk bumped over as used. flags may be left over from before a trim or reset,
+ * and handles from before a reset or restore may still name it, which dropped it without a delete
+ */
+static LS_INLINE void _ls_chunk_arena_recommit_fresh(ls_chunk_arena_s *chunk_arena, ls_u64_t chunk_i)
+{
+	_ls_chunk_arena_recommit(chunk_arena, chunk_i);
+
+	chunk_arena->_meta[chunk_i]._gen++;
+}
+
+
+static LS_INLINE void ls_chunk_arena_get_chunks(ls_chunk_arena_s *chunk_arena, ls_u64_t chunk_c, ls_void_p *chunk_a, ls_result_t *status)
+{
+	ls_u64_t head_i;
+	ls_u64_t chunk_i;
+	ls_u64_t run_i	= 0;  /* trimmed chunks [run_i, run_i + run_c) still need committing */
+	ls_u64_t run_c	= 0;
+	ls_u64_t span_i;
+	ls_u64_t span_c;
+	ls_u64_t i		= 0;
+
+	if (!chunk_arena->_scope_c && LS_CHUNK_ARENA_FREE_INDEX(chunk_arena->_depot))
+	{
+		_ls_chunk_arena_depot_drain(chunk_arena);
+	}
+
+	if (chunk_arena->_max_chunk_c - chunk_arena->_chunk_c < chunk_c || (chunk_arena->_scope_c && chunk_arena->_max_chunk_c - (chunk_arena->_next_committed_chunk - 1) < chunk_c))
+	{
+		*status = LS_CHUNK_ARENA_MEM_FULL;
+		return;
+	}
+	else
+	{
+		*status = LS_SUCCESS;
+	}
+
+	chunk_arena->_chunk_c += chunk_c;
+	_LS_CHUNK_ARENA_COUNT(chunk_arena, _get_c, chunk_c);
+
+	/* deleted chunks first, the free stack head is only written once */
+	head_i = LS_CHUNK_ARENA_FREE_INDEX(chunk_arena->_last_deleted_chunk);
+
+	for (; i < chunk_c && !chunk_arena->_scope_c; i++)
+	{
+		if (chunk_arena->_bitmap_depth && chunk_arena->_bitmap[chunk_arena->_bitmap_level_a[chunk_arena->_bitmap_depth - 1]])
+		{
+			chunk_i = _ls_chunk_arena_bitmap_lowest(chunk_arena);
+			_ls_chunk_arena_bitmap_clear(chunk_arena, chunk_i);
+		}
+		else if (head_i)
+		{
+			chunk_i = head_i - 1;
+			head_i	= chunk_arena->_meta[chunk_i]._next;
+		}
+		else
+		{
+			break;
+		}
+
+		if (chunk_arena->_meta[chunk_i]._flags & LS_CHUNK_ARENA_DECOMMITTED)
+		{
+			if (run_c && run_i + run_c != chunk_i)
+			{
+				_LS_CHUNK_ARENA_COMMIT(chunk_arena, run_i * chunk_arena->_chunk_size, run_c * chunk_arena->_chunk_size);
+				run_c = 0;
+			}
+
+			run_i = run_c ? run_i : chunk_i;
+			run_c++;
+		}
+
+		chunk_arena->_meta[chunk_i]._flags = 0;
+		chunk_a[i] = LS_CHUNK_ARENA_INDEX_TO_ADDR(chunk_arena, chunk_i);
+	}
+
+	if (run_c)
+	{
+		_LS_CHUNK_ARENA_COMMIT(chunk_arena, run_i * chunk_arena->_chunk_size, run_c * chunk_arena->_chunk_size);
+	}
+
+	chunk_arena->_last_deleted_chunk = LS_CHUNK_ARENA_FREE_WORD(head_i, LS_CHUNK_ARENA_FREE_TAG(chunk_arena->_last_deleted_chunk) + 1);
+
+	/* then free spans, split once for as many chunks as they hold */
+	while (i < chunk_c && !chunk_arena->_scope_c && (span_i = _ls_chunk_arena_span_find(chunk_arena, 1)))
+	{
+		span_c = chunk_arena->_meta[span_i - 1]._span_c;
+		span_c = (span_c > chunk_c - i) ? chunk_c - i : span_c;
+
+		_ls_chunk_arena_span_take(chunk_arena, span_i - 1, span_c);
+
+		for (chunk_i = span_i - 1; chunk_i < span_i - 1 + span_c; chunk_i++, i++)
+		{
+			chunk_arena->_meta[chunk_i]._flags	= 0;
+			chunk_arena->_meta[chunk_i]._span_c	= 1;
+			chunk_a[i] = LS_CHUNK_ARENA_INDEX_TO_ADDR(chunk_arena, chunk_i);
+		}
+	}
+
+	/* then fresh ones, committed up to the last in one window */
+	if (i < chunk_c)
+	{
+		_ls_chunk_arena_commit_to(chunk_arena, chunk_arena->_next_committed_chunk - 1 + (chunk_c - i) - 1);
+	}
+
+	for (; i < chunk_c; i++)
+	{
+		_ls_chunk_arena_recommit_fresh(chunk_arena, chunk_arena->_next_committed_chunk - 1);
+		chunk_a[i] = LS_CHUNK_ARENA_INDEX_TO_ADDR(chunk_arena, chunk_arena->_next_committed_chunk - 1);
+
+		chunk_arena->_next_committed_chunk++;
+	}
+}
+
+static LS_INLINE void ls_chunk_arena_delete_chunks(ls_chunk_arena_s *chunk_arena, ls_void_p const *chunk_a, ls_u64_t chunk_c)
+{
+	ls_u32_t trim_c = LS_CAST(chunk_arena->_trim_c, ls_u32_t);
+	ls_u64_t head_i = LS_CHUNK_ARENA_FREE_INDEX(chunk_arena->_last_deleted_chunk);
+	ls_u64_t chunk_i;
+	ls_u64_t i;
+
+	_LS_CHUNK_ARENA_COUNT(chunk_arena, _delete_c, chunk_c);
+
+	/* chain the chunks in order, the last one onto the current head, then publish the first */
+	for (i = chunk_c; i--;)
+	{
+		chunk_i = LS_CHUNK_ARENA_ADDR_TO_INDEX(chunk_arena, chunk_a[i]);
+
+		chunk_arena->_meta[chunk_i]._gen++;
+
+		if (_ls_chunk_arena_scope_drop(chunk_arena, chunk_i))
+		{
+			chunk_c--;
+			continue;
+		}
+
+		chunk_arena->_meta[chunk_i]._trim_c	= trim_c;
+		chunk_arena->_meta[chunk_i]._flags	= LS_CHUNK_ARENA_FREE;
+
+		if (chunk_arena->_bitmap_depth)
+		{
+			_ls_chunk_arena_bitmap_set(chunk_arena, chunk_i);
+			continue;
+		}
+
+		chunk_arena->_meta[chunk_i]._next = LS_CAST(head_i, ls_u32_t);
+		head_i = chunk_i + 1;
+	}
+
+	chunk_arena->_last_deleted_chunk = LS_CHUNK_ARENA_FREE_WORD(head_i, LS_CHUNK_ARENA_FREE_TAG(chunk_arena->_last_deleted_chunk) + 1);
+	chunk_arena->_chunk_c -= chunk_c;
+}
+
+
+static LS_INLINE ls_void_p ls_chunk_arena_get_span(ls_chunk_arena_s *chunk_arena, ls_u64_t chunk_c, ls_result_t *status)
+{
+	ls_u64_t chunk_i = chunk_arena->_scope_c ? 0 : _ls_chunk_arena_span_find(chunk_arena, chunk_c);
+	ls_u64_t i;
+
+	if (chunk_c == 0 || (!chunk_i && chunk_arena->_max_chunk_c - (chunk_arena->_next_committed_chunk - 1) < chunk_c))
+	{
+		*status = LS_CHUNK_ARENA_MEM_FULL;
+		return LS_NULL;
+	}
+	else
+	{
+		*status = LS_SUCCESS;
+	}
+
+	chunk_arena->_chunk_c += chunk_c;
+	_LS_CHUNK_ARENA_COUNT(chunk_arena, _get_c, chunk_c);
+
+	if (chunk_i)
+	{
+		chunk_i = LS_CHUNK_ARENA_ADDR_TO_INDEX(chunk_arena, _ls_chunk_arena_span_take(chunk_arena, chunk_i - 1, chunk_c));
+	}
+	else
+	{
+		chunk_i = chunk_arena->_next_committed_chunk - 1;
+		_ls_chunk_arena_commit_to(chunk_arena, chunk_i + chunk_c - 1);
+
+		for (i = 0; i < chunk_c; i++)
+		{
+			_ls_chunk_arena_recommit_fresh(chunk_arena, chunk_i + i);
+		}
+
+		chunk_arena->_next_committed_chunk += chunk_c;
+	}
+
+	_ls_chunk_arena_span_tag(chunk_arena, chunk_i, chunk_c);
+
+	return LS_CHUNK_ARENA_INDEX_TO_ADDR(chunk_arena, chunk_i);
+}
+
+static LS_INLINE void ls_chunk_arena_delete_span(ls_chunk_arena_s *chunk_arena, ls_void_p span_p)
+{
+	ls_u64_t chunk_i	= LS_CHUNK_ARENA_ADDR_TO_INDEX(chunk_arena, span_p);
+	ls_u64_t chunk_c	= chunk_arena->_meta[chunk_i]._span_c;
+	ls_u64_t end		= chunk_i + chunk_c;
+	ls_u64_t side_i;
+	ls_u64_t side_c;
+
+	chunk_arena->_meta[chunk_i]._gen++;
+	_LS_CHUNK_ARENA_COUNT(chunk_arena, _delete_c, chunk_c);
+
+	if (_ls_chunk_arena_scope_drop(chunk_arena, chunk_i))
+	{
+		return;
+	}
+
+	chunk_arena->_chunk_c -= chunk_c;
+	chunk_arena->_meta[end - 1]._flags = 0;  /* may end up inside the merged span */
+
+	/* boundary tags: the chunk past the end starts a free span, the one before the start ends one */
+	if (end < chunk_arena->_next_committed_chunk - 1 && (chunk_arena->_meta[end]._flags & LS_CHUNK_ARENA_SPAN_FREE))
+	{
+		side_c = chunk_arena->_meta[end]._span_c;
+
+		if (chunk_arena->_meta[end]._flags & LS_CHUNK_ARENA_DECOMMITTED)
+		{
+			/* a merged span is trimmed as a whole, commit charge only, nothing is faulted in */
+			_LS_CHUNK_ARENA_COMMIT(chunk_arena, end * chunk_arena->_chunk_size, side_c * chunk_arena->_chunk_size);
+		}
+
+		_ls_chunk_arena_span_unlink(chunk_arena, end);
+		chunk_arena->_meta[end]._flags = 0;
+
+		chunk_c += side_c;
+	}
+
+	if (chunk_i && (chunk_arena->_meta[chunk_i - 1]._flags & LS_CHUNK_ARENA_SPAN_FREE))
+	{
+		side_c = chunk_arena->_meta[chunk_i - 1]._span_c;
+		side_i = chunk_i - side_c;
+
+		if (chunk_arena->_meta[side_i]._flags & LS_CHUNK_ARENA_DECOMMITTED)
+		{
+			_LS_CHUNK_ARENA_COMMIT(chunk_arena, side_i * chunk_arena->_chunk_size, side_c * chunk_arena->_chunk_size);
+		}
+
+		_ls_chunk_arena_span_unlink(chunk_arena, side_i);
+		chunk_arena->_meta[chunk_i - 1]._flags = 0;
+
+		chunk_i  = side_i;
+		chunk_c += side_c;
+	}
+
+	_ls_chunk_arena_span_push(chunk_arena, chunk_i, chunk_c, 0);
+}
+
+/* 1-based index of the first chunk of a free span of at least [chunk_c] chunks, 0 if none */
+static LS_INLINE ls_u64_t _ls_chunk_arena_span_find(ls_chunk_arena_s *chunk_arena, ls_u64_t chunk_c)
+{
+	ls_u64_t bin;
+	ls_u64_t span_i;
+
+	if (chunk_c == 0 || chunk_c > LS_CHUNK_ARENA_MAX_CHUNK_C)
+	{
+		return 0;
+	}
+
+	/* spans in the bin of [chunk_c] may be too short, first fit */
+	for (span_i = chunk_arena->_span_bin_a[LS_FLOOR_LOG2(chunk_c)]; span_i; span_i = chunk_arena->_meta[span_i - 1]._next)
+	{
+		if (chunk_arena->_meta[span_i - 1]._span_c >= chunk_c)
+		{
+			return span_i;
+		}
+	}
+
+	/* every span of a higher bin fits */
+	for (bin = LS_FLOOR_LOG2(chunk_c) + 1; bin < LS_CHUNK_ARENA_SPAN_BIN_C; bin++)
+	{
+		if (chunk_arena->_span_bin_a[bin])
+		{
+			return chunk_arena->_span_bin_a[bin];
+		}
+	}
+
+	return 0;
+}
+
+/* hands out the first [chunk_c] chunks of free span [chunk_i], the rest stays free */
+static LS_INLINE ls_void_p _ls_chunk_arena_span_take(ls_chunk_arena_s *chunk_arena, ls_u64_t chunk_i, ls_u64_t chunk_c)
+{
+	ls_chunk_arena_meta_s *meta = &chunk_arena->_meta[chunk_i];
+	ls_u64_t span_c				= meta->_span_c;
+	ls_u32_t flags				= meta->_flags;
+
+	_ls_chunk_arena_span_unlink(chunk_arena, chunk_i);
+
+	if (flags & LS_CHUNK_ARENA_DECOMMITTED)
+	{
+		_LS_CHUNK_ARENA_COMMIT(chunk_arena, chunk_i * chunk_arena->_chunk_size, chunk_c * chunk_arena->_chunk_size);
+	}
+
+	if (span_c > chunk_c)
+	{
+		_ls_chunk_arena_span_push(chunk_arena, chunk_i + chunk_c, span_c - chunk_c, flags & LS_CHUNK_ARENA_DECOMMITTED);
+		chunk_arena->_meta[chunk_i + chunk_c]._trim_c = meta->_trim_c;
+	}
+	else
+	{
+		chunk_arena->_meta[chunk_i + span_c - 1]._flags = 0;
+	}
+
+	meta->_flags	= 0;
+	meta->_span_c	= LS_CAST(chunk_c, ls_u32_t);
+
+	return LS_CHUNK_ARENA_INDEX_TO_ADDR(chunk_arena, chunk_i);
+}
+
+/* tags [chunk_i, chunk_i + chunk_c) as a free span and puts it into its bin */
+static LS_INLINE void _ls_chunk_arena_span_push(ls_chunk_arena_s *chunk_arena, ls_u64_t chunk_i, ls_u64_t chunk_c, ls_u32_t flags)
+{
+	ls_chunk_arena_meta_s *meta = &chunk_arena->_meta[chunk_i];
+	ls_u32_t *bin_p				= &chunk_arena->_span_bin_a[LS_FLOOR_LOG2(chunk_c)];
+
+	chunk_arena->_meta[chunk_i + chunk_c - 1]._flags	= LS_CHUNK_ARENA_SPAN_FREE;
+	chunk_arena->_meta[chunk_i + chunk_c - 1]._span_c	= LS_CAST(chunk_c, ls_u32_t);
+
+	meta->_flags	= LS_CHUNK_ARENA_SPAN_FREE | flags;
+	meta->_span_c	= LS_CAST(chunk_c, ls_u32_t);
+	meta->_trim_c	= LS_CAST(chunk_arena->_trim_c, ls_u32_t);
+	meta->_link		= 0;
+	meta->_next		= *bin_p;
+
+	if (*bin_p)
+	{
+		chunk_arena->_meta[*bin_p - 1]._link = LS_CAST(chunk_i + 1, ls_u32_t);
+	}
+
+	*bin_p = LS_CAST(chunk_i + 1, ls_u32_t);
+}
+
+static LS_INLINE void _ls_chunk_arena_span_unlink(ls_chunk_arena_s *chunk_arena, ls_u64_t chunk_i)
+{
+	ls_chunk_arena_meta_s *meta = &chunk_arena->_meta[chunk_i];
+
+	if (meta->_link)
+	{
+		chunk_arena->_meta[meta->_link - 1]._next = meta->_next;
+	}
+	else
+	{
+		chunk_arena->_span_bin_a[LS_FLOOR_LOG2(meta->_span_c)] = meta->_next;
+	}
+
+	if (meta->_next)
+	{
+		chunk_arena->_meta[meta->_next - 1]._link = meta->_link;
+	}
+}
+
+
+/* tags [chunk_i, chunk_i + chunk_c) as a span handed out */
+static LS_INLINE void _ls_chunk_arena_span_tag(ls_chunk_arena_s *chunk_arena, ls_u64_t chunk_i, ls_u64_t chunk_c)
+{
+	chunk_arena->_meta[chunk_i + chunk_c - 1]._flags	= LS_CHUNK_ARENA_SPAN;
+	chunk_arena->_meta[chunk_i + chunk_c - 1]._span_c	= LS_CAST(chunk_c, ls_u32_t);
+	chunk_arena->_meta[chunk_i]._flags					= LS_CHUNK_ARENA_SPAN;
+	chunk_arena->_meta[chunk_i]._span_c					= LS_CAST(chunk_c, ls_u32_t);
+}
+
+
+static LS_INLINE ls_chunk_arena_handle_t ls_chunk_arena_handle(ls_chunk_arena_s *chunk_arena, ls_void_p chunk_p)
+{
+	ls_u64_t chunk_i = LS_CHUNK_ARENA_ADDR_TO_INDEX(chunk_arena, chunk_p);
+
+	if (chunk_i + 1 > LS_CHUNK_ARENA_HANDLE_INDEX_MASK)
+	{
+		return LS_CHUNK_ARENA_NULL_HANDLE;
+	}
+
+	return LS_CAST(chunk_i + 1, ls_u32_t) | ((chunk_arena->_meta[chunk_i]._gen & LS_CHUNK_ARENA_HANDLE_GEN_MASK) << LS_CHUNK_ARENA_HANDLE_INDEX_BITS);
+}
+
+static LS_INLINE ls_void_p ls_chunk_arena_resolve(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_handle_t handle)
+{
+	ls_u64_t chunk_i = handle & LS_CHUNK_ARENA_HANDLE_INDEX_MASK;
+	ls_chunk_arena_meta_s *meta;
+
+	if (chunk_i == 0 || chunk_i >= chunk_arena->_next_committed_chunk)
+	{
+		return LS_NULL;
+	}
+
+	meta = &chunk_arena->_meta[chunk_i - 1];
+
+	if ((meta->_gen & LS_CHUNK_ARENA_HANDLE_GEN_MASK) != (handle >> LS_CHUNK_ARENA_HANDLE_INDEX_BITS) || (meta->_flags & (LS_CHUNK_ARENA_FREE | LS_CHUNK_ARENA_SPAN_FREE)))
+	{
+		return LS_NULL;
+	}
+
+	return LS_CHUNK_ARENA_INDEX_TO_ADDR(chunk_arena, chunk_i - 1);
+}
+
+
+static LS_INLINE ls_chunk_arena_iter_s ls_chunk_arena_iter_init(void)
+{
+	ls_chunk_arena_iter_s iter;
+
+	iter._chunk_i = 0;
+
+	return iter;
+}
+
+static LS_INLINE ls_void_p ls_chunk_arena_iter_next(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_iter_s *iter, ls_u64_p chunk_c)
+{
+	ls_chunk_arena_meta_s *meta;
+
+	while (iter->_chunk_i < chunk_arena->_next_committed_chunk - 1)
+	{
+		meta = &chunk_arena->_meta[iter->_chunk_i];
+
+		if (meta->_flags & LS_CHUNK_ARENA_FREE)
+		{
+			iter->_chunk_i++;
+			continue;
+		}
+
+		if (meta->_flags & LS_CHUNK_ARENA_SPAN_FREE)
+		{
+			iter->_chunk_i += meta->_span_c;
+			continue;
+		}
+
+		*chunk_c		= (meta->_flags & LS_CHUNK_ARENA_SPAN) ? meta->_span_c : 1;
+		iter->_chunk_i += *chunk_c;
+
+		return LS_CHUNK_ARENA_INDEX_TO_ADDR(chunk_arena, iter->_chunk_i - *chunk_c);
+	}
+
+	return LS_NULL;
 }
 
 
+static LS_INLINE ls_u64_t ls_chunk_arena_compact(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_move_fn move_fn, ls_void_p user)
+{
+	ls_u64_t low		= 0;  /* chunks below [low] are live */
+	ls_u64_t high		= chunk_arena->_next_committed_chunk - 1;  /* chunks [high, top) are moved or free */
+	ls_u64_t moved_c	= 0;
+	ls_u64_t chunk_c;
+	ls_u64_t target;
+	ls_u64_t i;
+	ls_u32_t flags;
+
+	if (chunk_arena->_scope_c || _ls_chunk_arena_epoch_pending(chunk_arena))
+	{
+		return 0;
+	}
+
+	/* flushing magazines fills the depot, its chunks are as free as any other here */
+	_ls_chunk_arena_depot_drain(chunk_arena);
+
+	/* the free lists are rebuilt from the flags afterwards, free spans are split into free chunks as they are met */
+	while (low < high)
+	{
+		flags = chunk_arena->_meta[high - 1]._flags;
+
+		if (flags & LS_CHUNK_ARENA_FREE)
+		{
+			high--;
+			continue;
+		}
+
+		if (flags & LS_CHUNK_ARENA_SPAN_FREE)
+		{
+			high -= chunk_arena->_meta[high - 1]._span_c;
+			continue;
+		}
+
+		chunk_c = (flags & LS_CHUNK_ARENA_SPAN) ? chunk_arena->_meta[high - 1]._span_c : 1;
+
+		while (low < high - chunk_c && _ls_chunk_arena_compact_free_run(chunk_arena, low, low + 1) == low)
+		{
+			low += (chunk_arena->_meta[low]._flags & LS_CHUNK_ARENA_SPAN) ? chunk_arena->_meta[low]._span_c : 1;
+		}
+
+		/* the lowest run of [chunk_c] free chunks below the chunk or span */
+		for (target = low; target + chunk_c <= high - chunk_c; )
+		{
+			i = _ls_chunk_arena_compact_free_run(chunk_arena, target, target + chunk_c);
+
+			if (i == target + chunk_c)
+			{
+				break;
+			}
+
+			target = (i > target) ? i : target + ((chunk_arena->_meta[i]._flags & LS_CHUNK_ARENA_SPAN) ? chunk_arena->_meta[i]._span_c : 1);
+		}
+
+		if (target + chunk_c > high - chunk_c)
+		{
+			break;
+		}
+
+		high -= chunk_c;
+
+		/* handles of the old place go stale, [move_fn] makes new ones */
+		chunk_arena->_meta[high]._gen++;
+
+		for (i = 0; i < chunk_c; i++)
+		{
+			_ls_chunk_arena_recommit(chunk_arena, target + i);
+
+			chunk_arena->_meta[high + i]._trim_c	= LS_CAST(chunk_arena->_trim_c, ls_u32_t);
+			chunk_arena->_meta[high + i]._flags		= LS_CHUNK_ARENA_FREE;
+		}
+
+		if (flags & LS_CHUNK_ARENA_SPAN)
+		{
+			_ls_chunk_arena_span_tag(chunk_arena, target, chunk_c);
+		}
+
+		LS_MEMCPY(LS_CHUNK_ARENA_INDEX_TO_ADDR(chunk_arena, target), LS_CHUNK_ARENA_INDEX_TO_ADDR(chunk_arena, high), chunk_c * chunk_arena->_chunk_size);
+		move_fn(LS_CHUNK_ARENA_INDEX_TO_ADDR(chunk_arena, high), LS_CHUNK_ARENA_INDEX_TO_ADDR(chunk_arena, target), chunk_c, user);
+
+		moved_c += chunk_c;
+	}
+
+	_ls_chunk_arena_compact_rebuild(chunk_arena, high);
+
+	/* idle chunks are left to the next regular trim */
+	ls_chunk_arena_trim(chunk_arena, LS_CHUNK_ARENA_MAX_CHUNK_C);
+
+	return moved_c;
+}
+
+/* returns the first chunk in [chunk_i, end) that is not free, splitting free spans met into free chunks */
+static LS_INLINE ls_u64_t _ls_chunk_arena_compact_free_run(ls_chunk_arena_s *chunk_arena, ls_u64_t chunk_i, ls_u64_t end)
+{
+	ls_chunk_arena_meta_s *meta;
+	ls_u64_t i;
+
+	for (; chunk_i < end; chunk_i++)
+	{
+		meta = &chunk_arena->_meta[chunk_i];
+
+		if (meta->_flags & LS_CHUNK_ARENA_SPAN_FREE)
+		{
+			for (i = meta->_span_c; i--;)
+			{
+				chunk_arena->_meta[chunk_i + i]._trim_c	= meta->_trim_c;
+				chunk_arena->_meta[chunk_i + i]._flags	= LS_CHUNK_ARENA_FREE | (meta->_flags & LS_CHUNK_ARENA_DECOMMITTED);
+			}
+		}
+
+		if (!(meta->_flags & LS_CHUNK_ARENA_FREE))
+		{
+			return chunk_i;
+		}
+	}
+
+	return end;
+}
+
+/* rebuilds the free stack or bitmap and the span bins from the flags of chunks [0, top) */
+static LS_INLINE void _ls_chunk_arena_compact_rebuild(ls_chunk_arena_s *chunk_arena, ls_u64_t top)
+{
+	ls_u64_t old_top	= chunk_arena->_next_committed_chunk - 1;
+	ls_u64_t chunk_i	= 0;
+	ls_u64_t run_c;
+	ls_u64_t level;
+	ls_u64_t i;
+	ls_u32_t head_i		= 0;
+	ls_u32_p link_p		= &head_i;
+	ls_u32_t trim_c;
+	ls_u32_t flags;
+
+	for (level = 0; level < chunk_arena->_bitmap_depth; level++)
+	{
+		old_top = (old_top + 63) / 64;
+		LS_MEMSET(chunk_arena->_bitmap + chunk_arena->_bitmap_level_a[level], 0, old_top * sizeof(ls_u64_t));
+	}
+
+	LS_MEMSET(chunk_arena->_span_bin_a, 0, sizeof(chunk_arena->_span_bin_a));
+
+	while (chunk_i < top)
+	{
+		flags = chunk_arena->_meta[chunk_i]._flags;
+
+		if (!(flags & (LS_CHUNK_ARENA_FREE | LS_CHUNK_ARENA_SPAN_FREE)))
+		{
+			chunk_i += (flags & LS_CHUNK_ARENA_SPAN) ? chunk_arena->_meta[chunk_i]._span_c : 1;
+			continue;
+		}
+
+		if (flags & LS_CHUNK_ARENA_SPAN_FREE)
+		{
+			/* pushing resets the trim count */
+			trim_c	= chunk_arena->_meta[chunk_i]._trim_c;
+			run_c	= chunk_arena->_meta[chunk_i]._span_c;
+
+			_ls_chunk_arena_span_push(chunk_arena, chunk_i, run_c, flags & LS_CHUNK_ARENA_DECOMMITTED);
+			chunk_arena->_meta[chunk_i]._trim_c = trim_c;
+
+			chunk_i += run_c;
+			continue;
+		}
+
+		/*
+		 * free chunks next to each other become a span, as long as they agree on being committed.
+		 * ordered arenas keep them in the bitmap, spans would hand them out out of order
+		 */
+		trim_c	= chunk_arena->_meta[chunk_i]._trim_c;
+		run_c	= 1;
+
+		while (!chunk_arena->_bitmap_depth && chunk_i + run_c < top && chunk_arena->_meta[chunk_i + run_c]._flags == flags)
+		{
+			trim_c = (LS_CAST(chunk_arena->_meta[chunk_i + run_c]._trim_c - trim_c, ls_s32_t) > 0) ? chunk_arena->_meta[chunk_i + run_c]._trim_c : trim_c;
+			run_c++;
+		}
+
+		if (run_c > 1)
+		{
+			_ls_chunk_arena_span_push(chunk_arena, chunk_i, run_c, flags & LS_CHUNK_ARENA_DECOMMITTED);
+			chunk_arena->_meta[chunk_i]._trim_c = trim_c;
+
+			/* the inside of a span is never looked at */
+			for (i = 1; i < run_c - 1; i++)
+			{
+				chunk_arena->_meta[chunk_i + i]._flags = 0;
+			}
+		}
+		else if (chunk_arena->_bitmap_depth)
+		{
+			_ls_chunk_arena_bitmap_set(chunk_arena, chunk_i);
+		}
+		else
+		{
+			/* appended, so the stack pops in address order */
+			*link_p = LS_CAST(chunk_i + 1, ls_u32_t);
+			link_p	= &chunk_arena->_meta[chunk_i]._next;
+		}
+
+		chunk_i += run_c;
+	}
+
+	*link_p = 0;
+
+	chunk_arena->_last_deleted_chunk	= LS_CHUNK_ARENA_FREE_WORD(head_i, LS_CHUNK_ARENA_FREE_TAG(chunk_arena->_last_deleted_chunk) + 1);
+	chunk_arena->_next_committed_chunk	= top + 1;
+}
+
+
+/* index of the lowest deleted chunk, the bitmap must not be empty */
+static LS_INLINE ls_u64_t _ls_chunk_arena_bitmap_lowest(ls_chunk_arena_s *chunk_arena)
+{
+	ls_u64_t word_i = 0;
+	ls_u64_t level	= chunk_arena->_bitmap_depth;
+
+	while (level--)
+	{
+		word_i = word_i * 64 + __builtin_ctzll(chunk_arena->_bitmap[chunk_arena->_bitmap_level_a[level] + word_i]);
+	}
+
+	return word_i;
+}
+
+static LS_INLINE void _ls_chunk_arena_bitmap_set(ls_chunk_arena_s *chunk_arena, ls_u64_t chunk_i)
+{
+	ls_u64_t level;
+	ls_u64_p word_p;
+
+	/* stop at the first level that already had a bit set, the ones above know of it */
+	for (level = 0; level < chunk_arena->_bitmap_depth; level++)
+	{
+		word_p	= &chunk_arena->_bitmap[chunk_arena->_bitmap_level_a[level] + chunk_i / 64];
+		*word_p |= 1llu << (chunk_i % 64);
+
+		if (*word_p != 1llu << (chunk_i % 64))
+		{
+			return;
+		}
+
+		chunk_i /= 64;
+	}
+}
+
+static LS_INLINE void _ls_chunk_arena_bitmap_clear(ls_chunk_arena_s *chunk_arena, ls_u64_t chunk_i)
+{
+	ls_u64_t level;
+	ls_u64_p word_p;
+
+	for (level = 0; level < chunk_arena->_bitmap_depth; level++)
+	{
+		word_p	= &chunk_arena->_bitmap[chunk_arena->_bitmap_level_a[level] + chunk_i / 64];
+		*word_p &= ~(1llu << (chunk_i % 64));
+
+		if (*word_p)
+		{
+			return;
+		}
+
+		chunk_i /= 64;
+	}
+}
+
+
+static LS_INLINE void ls_chunk_arena_reset(ls_chunk_arena_s *chunk_arena, ls_bool_t decommit)
+{
+	ls_u64_t top	= chunk_arena->_next_committed_chunk - 1;
+	ls_u64_t level;
+	ls_u64_t bin;
+	ls_u64_t chunk_i;
+	ls_chunk_arena_epoch_s *epoch;
+
+	if (decommit && chunk_arena->_committed_chunk_c)
+	{
+		/* metadata stays, the generations of dropped chunks must survive */
+		_ls_chunk_arena_alloca_decommit_range(chunk_arena->_memory, 0, chunk_arena->_committed_chunk_c * chunk_arena->_chunk_size);
+
+		chunk_arena->_committed_chunk_c = 0;
+	}
+	else
+	{
+		/* only the first chunk of a trimmed span knows, single chunks are committed again once bumped over */
+		for (bin = 0; bin < LS_CHUNK_ARENA_SPAN_BIN_C; bin++)
+		{
+			for (chunk_i = chunk_arena->_span_bin_a[bin]; chunk_i; chunk_i = chunk_arena->_meta[chunk_i - 1]._next)
+			{
+				if (chunk_arena->_meta[chunk_i - 1]._flags & LS_CHUNK_ARENA_DECOMMITTED)
+				{
+					_LS_CHUNK_ARENA_COMMIT(chunk_arena, (chunk_i - 1) * chunk_arena->_chunk_size,
+						chunk_arena->_meta[chunk_i - 1]._span_c * chunk_arena->_chunk_size);
+
+					chunk_arena->_meta[chunk_i - 1]._flags &= ~LS_CHUNK_ARENA_DECOMMITTED;
+				}
+			}
+		}
+	}
+
+	/* only the words covering chunks handed out can have bits set */
+	for (level = 0; level < chunk_arena->_bitmap_depth; level++)
+	{
+		top = (top + 63) / 64;
+		LS_MEMSET(chunk_arena->_bitmap + chunk_arena->_bitmap_level_a[level], 0, top * sizeof(ls_u64_t));
+	}
+
+	LS_MEMSET(chunk_arena->_span_bin_a, 0, sizeof(chunk_arena->_span_bin_a));
+
+	chunk_arena->_chunk_c				= 0;
+	chunk_arena->_next_committed_chunk	= 1;
+	chunk_arena->_last_deleted_chunk	= LS_CHUNK_ARENA_FREE_WORD(0, LS_CHUNK_ARENA_FREE_TAG(chunk_arena->_last_deleted_chunk) + 1);
+	chunk_arena->_depot					= 0;
+	chunk_arena->_scope_c				= 0;
+	chunk_arena->_scope_floor			= 0;
+
+	for (epoch = chunk_arena->_epoch_list; epoch; epoch = epoch->_next)
+	{
+		LS_MEMSET(epoch->_limbo_a, 0, sizeof(epoch->_limbo_a));
+	}
+}
+
+
+static LS_INLINE ls_chunk_arena_checkpoint_s ls_chunk_arena_checkpoint(ls_chunk_arena_s *chunk_arena)
+{
+	ls_chunk_arena_checkpoint_s checkpoint;
+
+	checkpoint._mark = chunk_arena->_next_committed_chunk;
+
+	if (!chunk_arena->_scope_c++)
+	{
+		chunk_arena->_scope_floor = checkpoint._mark - 1;
+	}
+
+	return checkpoint;
+}
+
+static LS_INLINE void ls_chunk_arena_restore(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_checkpoint_s checkpoint)
+{
+	/* chunks deleted in a scope were never taken off [_chunk_c] */
+	chunk_arena->_chunk_c				-= chunk_arena->_next_committed_chunk - checkpoint._mark;
+	chunk_arena->_next_committed_chunk	 = checkpoint._mark;
+
+	if (!--chunk_arena->_scope_c)
+	{
+		chunk_arena->_scope_floor = 0;
+	}
+}
+
+/* a chunk handed out in an open scope is not deleted, its scope drops it when restored */
+static LS_INLINE ls_bool_t _ls_chunk_arena_scope_drop(ls_chunk_arena_s *chunk_arena, ls_u64_t chunk_i)
+{
+	return chunk_arena->_scope_c && chunk_i >= chunk_arena->_scope_floor;
+}
+
+
+static LS_INLINE void ls_chunk_arena_trim(ls_chunk_arena_s *chunk_arena, ls_u64_t idle_c)
+{
+	ls_u64_t top	= chunk_arena->_next_committed_chunk - 1;  /* chunks [0, top) were handed out */
+	ls_u64_t trimmed_c	= 0;
+	ls_u64_t chunk_i;
+	ls_u64_t word;
+	ls_u64_t bin;
+	ls_u32_p link_p;
+	ls_u32_t head_i;
+
+	chunk_arena->_trim_c++;
+
+	/* the run of deleted chunks and free spans ending at [top], open scopes keep their chunks */
+	while (top > chunk_arena->_scope_floor)
+	{
+		if (chunk_arena->_meta[top - 1]._flags & LS_CHUNK_ARENA_FREE)
+		{
+			top--;
+		}
+		else if (chunk_arena->_meta[top - 1]._flags & LS_CHUNK_ARENA_SPAN_FREE)
+		{
+			top -= chunk_arena->_meta[top - 1]._span_c;
+			_ls_chunk_arena_span_unlink(chunk_arena, top);
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	for (bin = 0; bin < LS_CHUNK_ARENA_SPAN_BIN_C; bin++)
+	{
+		for (chunk_i = chunk_arena->_span_bin_a[bin]; chunk_i; chunk_i = chunk_arena->_meta[chunk_i - 1]._next)
+		{
+			trimmed_c += _ls_chunk_arena_trim_chunk(chunk_arena, chunk_i - 1, idle_c);
+		}
+	}
+
+	if (chunk_arena->_bitmap_depth)
+	{
+		for (chunk_i = top; chunk_i < chunk_arena->_next_committed_chunk - 1; chunk_i++)
+		{
+			_ls_chunk_arena_bitmap_clear(chunk_arena, chunk_i);
+		}
+
+		for (chunk_i = 0; chunk_i < top; chunk_i += 64)
+		{
+			word = chunk_arena->_bitmap[chunk_arena->_bitmap_level_a[0] + chunk_i / 64];
+
+			while (word)
+			{
+				trimmed_c += _ls_chunk_arena_trim_chunk(chunk_arena, chunk_i + __builtin_ctzll(word), idle_c);
+				word &= word - 1;
+			}
+		}
+	}
+
+	/* unlink the run, then decommit every chunk interior to the arena that was idle long enough */
+	head_i = LS_CAST(LS_CHUNK_ARENA_FREE_INDEX(chunk_arena->_last_deleted_chunk), ls_u32_t);
+	link_p = &head_i;
+
+	while (*link_p)
+	{
+		chunk_i = *link_p - 1;
+
+		if (chunk_i >= top)
+		{
+			*link_p = chunk_arena->_meta[chunk_i]._next;
+			continue;
+		}
+
+		trimmed_c += _ls_chunk_arena_trim_chunk(chunk_arena, chunk_i, idle_c);
+
+		link_p = &chunk_arena->_meta[chunk_i]._next;
+	}
+
+	if (trimmed_c)
+	{
+		_ls_chunk_arena_trim_release(chunk_arena, top);
+	}
+
+	/* the tag of [_last_deleted_chunk] is kept */
+	chunk_arena->_last_deleted_chunk = LS_CHUNK_ARENA_FREE_WORD(head_i, LS_CHUNK_ARENA_FREE_TAG(chunk_arena->_last_deleted_chunk));
+
+	if (top < chunk_arena->_committed_chunk_c)
+	{
+		/* metadata stays, handles to the chunks must keep failing */
+		_ls_chunk_arena_alloca_decommit_range(chunk_arena->_memory, top * chunk_arena->_chunk_size,
+			(chunk_arena->_committed_chunk_c - top) * chunk_arena->_chunk_size);
+
+		chunk_arena->_committed_chunk_c = top;
+	}
+
+	chunk_arena->_next_committed_chunk = top + 1;
+}
+
+/* marks deleted chunk or free span [chunk_i] decommitted if it was idle for more than [idle_c] trims */
+static LS_INLINE ls_bool_t _ls_chunk_arena_trim_chunk(ls_chunk_arena_s *chunk_arena, ls_u64_t chunk_i, ls_u64_t idle_c)
+{
+	ls_chunk_arena_meta_s *meta = &chunk_arena->_meta[chunk_i];
+
+	if (!(meta->_flags & LS_CHUNK_ARENA_DECOMMITTED) && LS_CAST(LS_CAST(chunk_arena->_trim_c, ls_u32_t) - meta->_trim_c, ls_u32_t) > idle_c)
+	{
+		meta->_flags |= LS_CHUNK_ARENA_DECOMMITTED | LS_CHUNK_ARENA_TRIMMED;
+		return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * decommits every run of adjacent decommitted chunks below [top] holding a chunk marked by this trim
+ * in one call. runs take in chunks decommitted by earlier trims, so chunks smaller than a page are
+ * released once their neighbours idled too
+ */
+static LS_INLINE void _ls_chunk_arena_trim_release(ls_chunk_arena_s *chunk_arena, ls_u64_t top)
+{
+	ls_chunk_arena_meta_s *meta;
+	ls_u64_t run_i		= 0;
+	ls_u64_t run_c		= 0;
+	ls_u32_t trimmed	= 0;
+	ls_u64_t chunk_c;
+	ls_u64_t chunk_i;
+
+	for (chunk_i = 0; chunk_i <= top; chunk_i += chunk_c)
+	{
+		meta	= &chunk_arena->_meta[chunk_i];
+		chunk_c	= 1;
+
+		if (chunk_i < top && (meta->_flags & LS_CHUNK_ARENA_DECOMMITTED))
+		{
+			chunk_c		 = (meta->_flags & LS_CHUNK_ARENA_SPAN_FREE) ? meta->_span_c : 1;
+			run_i		 = run_c ? run_i : chunk_i;
+			run_c		+= chunk_c;
+			trimmed		|= meta->_flags & LS_CHUNK_ARENA_TRIMMED;
+			meta->_flags &= ~LS_CHUNK_ARENA_TRIMMED;
+
+			continue;
+		}
+
+		if (trimmed)
+		{
+			_ls_chunk_arena_alloca_decommit_range(chunk_arena->_memory, run_i * chunk_arena->_chunk_size, run_c * chunk_arena->_chunk_size);
+		}
+
+		/* spans handed out are skipped whole */
+		chunk_c	= (chunk_i < top && (meta->_flags & LS_CHUNK_ARENA_SPAN)) ? meta->_span_c : 1;
+		run_c	= 0;
+		trimmed	= 0;
+	}
+}
+
+
+static LS_INLINE ls_void_p ls_chunk_arena_get_chunk_atomic(ls_chunk_arena_s *chunk_arena, ls_result_t *status)
+{
+	ls_u64_t chunk_c = __atomic_load_n(&chunk_arena->_chunk_c, __ATOMIC_RELAXED);
+
+	/* reserve a chunk first, there is then always one to be found below */
+	do
+	{
+		if (chunk_c == chunk_arena->_max_chunk_c)
+		{
+			*status = LS_CHUNK_ARENA_MEM_FULL;
+			return LS_NULL;
+		}
+	}
+	while (!__atomic_compare_exchange_n(&chunk_arena->_chunk_c, &chunk_c, chunk_c + 1, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+
+	*status = LS_SUCCESS;
+	_LS_CHUNK_ARENA_COUNT_ATOMIC(chunk_arena, _get_c, 1);
+
+	return LS_CHUNK_ARENA_INDEX_TO_ADDR(chunk_arena, _ls_chunk_arena_take_atomic(chunk_arena) - 1);
+}
+
+/* finds the chunk of a reservation made by the caller, returns its 1-based index */
+static LS_INLINE ls_u64_t _ls_chunk_arena_take_atomic(ls_chunk_arena_s *chunk_arena)
+{
+	ls_u64_t head;
+	ls_u64_t chunk_i;
+
+	for (;;)
+	{
+		chunk_i = _ls_chunk_arena_pop_atomic(chunk_arena);
+
+		if (chunk_i || _ls_chunk_arena_bump_atomic(chunk_arena, 1, &chunk_i))
+		{
+			return chunk_i;
+		}
+
+		chunk_i = _ls_chunk_arena_depot_take(chunk_arena);
+
+		if (chunk_i && LS_CHUNK_ARENA_MAGAZINE_SIZE == 1)
+		{
+			return chunk_i;
+		}
+
+		if (chunk_i)
+		{
+			/* keep the first chunk of the batch, the rest goes onto the free stack */
+			ls_u32_t trim_c					= LS_CAST(__atomic_load_n(&chunk_arena->_trim_c, __ATOMIC_RELAXED), ls_u32_t);
+			ls_u64_t first_i				= chunk_arena->_meta[chunk_i - 1]._next;
+			ls_chunk_arena_meta_s *last		= &chunk_arena->_meta[first_i - 1];
+
+			for (;;)
+			{
+				last->_trim_c	= trim_c;
+				last->_flags	= LS_CHUNK_ARENA_FREE;
+
+				if (!last->_next)
+				{
+					break;
+				}
+
+				last = &chunk_arena->_meta[last->_next - 1];
+			}
+
+			head = __atomic_load_n(&chunk_arena->_last_deleted_chunk, __ATOMIC_RELAXED);
+
+			do
+			{
+				__atomic_store_n(&last->_next, LS_CAST(LS_CHUNK_ARENA_FREE_INDEX(head), ls_u32_t), __ATOMIC_RELAXED);
+			}
+			while (!__atomic_compare_exchange_n(&chunk_arena->_last_deleted_chunk, &head, LS_CHUNK_ARENA_FREE_WORD(first_i, LS_CHUNK_ARENA_FREE_TAG(head) + 1),
+				1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+			return chunk_i;
+		}
+
+		/* every chunk is committed: a delete that released our reservation is still pushing its chunk */
+	}
+}
+
+/* pops the free stack, returns the 1-based index of the chunk or 0 if empty */
+static LS_INLINE ls_u64_t _ls_chunk_arena_pop_atomic(ls_chunk_arena_s *chunk_arena)
+{
+	ls_u64_t head = __atomic_load_n(&chunk_arena->_last_deleted_chunk, __ATOMIC_ACQUIRE);
+	ls_u64_t next;
+
+	while (LS_CHUNK_ARENA_FREE_INDEX(head))
+	{
+		/* may read a chunk another thread already popped, the tag then fails the exchange */
+		next = __atomic_load_n(&chunk_arena->_meta[LS_CHUNK_ARENA_FREE_INDEX(head) - 1]._next, __ATOMIC_RELAXED);
+
+		if (__atomic_compare_exchange_n(&chunk_arena->_last_deleted_chunk, &head, LS_CHUNK_ARENA_FREE_WORD(next, LS_CHUNK_ARENA_FREE_TAG(head) + 1),
+			1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+		{
+			_ls_chunk_arena_recommit(chunk_arena, LS_CHUNK_ARENA_FREE_INDEX(head) - 1);
+
+			return LS_CHUNK_ARENA_FREE_INDEX(head);
+		}
+	}
+
+	return 0;
+}
+
+/* claims up to [chunk_c] fresh chunks in one exchange, returns how many and the 1-based index of the first in [chunk_i] */
+static LS_INLINE ls_u64_t _ls_chunk_arena_bump_atomic(ls_chunk_arena_s *chunk_arena, ls_u64_t chunk_c, ls_u64_p chunk_i)
+{
+	ls_u64_t next = __atomic_load_n(&chunk_arena->_next_committed_chunk, __ATOMIC_RELAXED);
+	ls_u64_t i;
+
+	do
+	{
+		if (next > chunk_arena->_max_chunk_c)
+		{
+			return 0;
+		}
+
+		chunk_c = (chunk_c > chunk_arena->_max_chunk_c + 1 - next) ? chunk_arena->_max_chunk_c + 1 - next : chunk_c;
+	}
+	while (!__atomic_compare_exchange_n(&chunk_arena->_next_committed_chunk, &next, next + chunk_c, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+	_ls_chunk_arena_commit_to_atomic(chunk_arena, next + chunk_c - 2);
+
+	for (i = next - 1; i < next - 1 + chunk_c; i++)
+	{
+		_ls_chunk_arena_recommit_fresh(chunk_arena, i);
+	}
+
+	*chunk_i = next;
+
+	return chunk_c;
+}
+
+
+static LS_INLINE void ls_chunk_arena_delete_chunk_atomic(ls_chunk_arena_s *chunk_arena, ls_void_p chunk_p)
+{
+	ls_u64_t chunk_i				= LS_CHUNK_ARENA_ADDR_TO_INDEX(chunk_arena, chunk_p);
+	ls_u64_t head					= __atomic_load_n(&chunk_arena->_last_deleted_chunk, __ATOMIC_RELAXED);
+	ls_chunk_arena_meta_s *meta		= &chunk_arena->_meta[chunk_i];
+
+	meta->_trim_c	= LS_CAST(__atomic_load_n(&chunk_arena->_trim_c, __ATOMIC_RELAXED), ls_u32_t);
+	meta->_flags	= LS_CHUNK_ARENA_FREE;
+	meta->_gen++;
+
+	do
+	{
+		__atomic_store_n(&meta->_next, LS_CAST(LS_CHUNK_ARENA_FREE_INDEX(head), ls_u32_t), __ATOMIC_RELAXED);
+	}
+	while (!__atomic_compare_exchange_n(&chunk_arena->_last_deleted_chunk, &head, LS_CHUNK_ARENA_FREE_WORD(chunk_i + 1, LS_CHUNK_ARENA_FREE_TAG(head) + 1),
+		1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+	/* only after the push, so a reserved chunk is always reachable */
+	__atomic_fetch_sub(&chunk_arena->_chunk_c, 1, __ATOMIC_RELEASE);
+	_LS_CHUNK_ARENA_COUNT_ATOMIC(chunk_arena, _delete_c, 1);
+}
+
+
+/* pops a batch off the depot and returns the 1-based index of its first chunk, 0 if empty */
+static LS_INLINE ls_u64_t _ls_chunk_arena_depot_take(ls_chunk_arena_s *chunk_arena)
+{
+	ls_u64_t head = __atomic_load_n(&chunk_arena->_depot, __ATOMIC_ACQUIRE);
+	ls_u64_t next;
+
+	while (LS_CHUNK_ARENA_FREE_INDEX(head))
+	{
+		next = __atomic_load_n(&chunk_arena->_meta[LS_CHUNK_ARENA_FREE_INDEX(head) - 1]._link, __ATOMIC_RELAXED);
+
+		if (__atomic_compare_exchange_n(&chunk_arena->_depot, &head, LS_CHUNK_ARENA_FREE_WORD(next, LS_CHUNK_ARENA_FREE_TAG(head) + 1),
+			1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+		{
+			return LS_CHUNK_ARENA_FREE_INDEX(head);
+		}
+	}
+
+	return 0;
+}
+
+/* chains LS_CHUNK_ARENA_MAGAZINE_SIZE chunks of [round_a] into a batch and pushes it onto the depot */
+static LS_INLINE void _ls_chunk_arena_depot_give(ls_chunk_arena_s *chunk_arena, ls_u32_t const *round_a)
+{
+	ls_chunk_arena_meta_s *first = &chunk_arena->_meta[round_a[0] - 1];
+	ls_u64_t head;
+	ls_u32_t i;
+
+	for (i = 0; i < LS_CHUNK_ARENA_MAGAZINE_SIZE; i++)
+	{
+		chunk_arena->_meta[round_a[i] - 1]._next = (i + 1 < LS_CHUNK_ARENA_MAGAZINE_SIZE) ? round_a[i + 1] : 0;
+	}
+
+	head = __atomic_load_n(&chunk_arena->_depot, __ATOMIC_RELAXED);
+
+	do
+	{
+		__atomic_store_n(&first->_link, LS_CAST(LS_CHUNK_ARENA_FREE_INDEX(head), ls_u32_t), __ATOMIC_RELAXED);
+	}
+	while (!__atomic_compare_exchange_n(&chunk_arena->_depot, &head, LS_CHUNK_ARENA_FREE_WORD(round_a[0], LS_CHUNK_ARENA_FREE_TAG(head) + 1),
+		1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+	__atomic_fetch_sub(&chunk_arena->_chunk_c, LS_CHUNK_ARENA_MAGAZINE_SIZE, __ATOMIC_RELEASE);
+	_LS_CHUNK_ARENA_COUNT_ATOMIC(chunk_arena, _delete_c, LS_CHUNK_ARENA_MAGAZINE_SIZE);
+}
+
+
+/*
+ * splices every depot batch onto the free stack, for the functions that need the arena locked.
+ * depot chunks are not counted in [_chunk_c], so they must be reachable before fresh chunks run out
+ */
+static LS_INLINE void _ls_chunk_arena_depot_drain(ls_chunk_arena_s *chunk_arena)
+{
+	ls_u32_t trim_c		= LS_CAST(chunk_arena->_trim_c, ls_u32_t);
+	ls_u64_t batch_i	= LS_CHUNK_ARENA_FREE_INDEX(chunk_arena->_depot);
+	ls_u64_t head_i		= LS_CHUNK_ARENA_FREE_INDEX(chunk_arena->_last_deleted_chunk);
+	ls_u64_t next_i;
+	ls_chunk_arena_meta_s *last;
+
+	while (batch_i)
+	{
+		next_i	= chunk_arena->_meta[batch_i - 1]._link;
+		last	= &chunk_arena->_meta[batch_i - 1];
+
+		for (;;)
+		{
+			last->_trim_c	= trim_c;
+			last->_flags	= LS_CHUNK_ARENA_FREE;
+
+			if (!last->_next)
+			{
+				break;
+			}
+
+			last = &chunk_arena->_meta[last->_next - 1];
+		}
+
+		last->_next	= LS_CAST(head_i, ls_u32_t);
+		head_i		= batch_i;
+		batch_i		= next_i;
+	}
+
+	chunk_arena->_last_deleted_chunk	= LS_CHUNK_ARENA_FREE_WORD(head_i, LS_CHUNK_ARENA_FREE_TAG(chunk_arena->_last_deleted_chunk) + 1);
+	chunk_arena->_depot					= LS_CHUNK_ARENA_FREE_WORD(0, LS_CHUNK_ARENA_FREE_TAG(chunk_arena->_depot) + 1);
+}
+
+
+static LS_INLINE ls_chunk_arena_magazine_s ls_chunk_arena_magazine_init(void)
+{
+	ls_chunk_arena_magazine_s magazine;
+
+	magazine._round_c = 0;
+
+	return magazine;
+}
+
+static LS_INLINE ls_void_p ls_chunk_arena_magazine_get_chunk(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_magazine_s *magazine, ls_result_t *status)
+{
+	ls_u64_t chunk_c;
+	ls_u64_t chunk_i;
+	ls_u64_t next_i;
+	ls_u64_t bump_c;
+	ls_u64_t round_i;
+
+	if (magazine->_round_c)
+	{
+		*status = LS_SUCCESS;
+
+		magazine->_round_c--;
+		return LS_CHUNK_ARENA_INDEX_TO_ADDR(chunk_arena, magazine->_round_a[magazine->_round_c] - 1);
+	}
+
+	/* reserve a whole batch before taking one from the depot */
+	chunk_c = __atomic_load_n(&chunk_arena->_chunk_c, __ATOMIC_RELAXED);
+
+	do
+	{
+		if (chunk_c + LS_CHUNK_ARENA_MAGAZINE_SIZE > chunk_arena->_max_chunk_c)
+		{
+			return ls_chunk_arena_get_chunk_atomic(chunk_arena, status);
+		}
+	}
+	while (!__atomic_compare_exchange_n(&chunk_arena->_chunk_c, &chunk_c, chunk_c + LS_CHUNK_ARENA_MAGAZINE_SIZE, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+
+	*status = LS_SUCCESS;
+	_LS_CHUNK_ARENA_COUNT_ATOMIC(chunk_arena, _get_c, LS_CHUNK_ARENA_MAGAZINE_SIZE);
+
+	chunk_i = _ls_chunk_arena_depot_take(chunk_arena);
+
+	if (!chunk_i)
+	{
+		/*
+		 * no batch to take, the reserved chunks are gathered from the free stack, then fresh ones claimed at once.
+		 * filled from the top down, so they are handed out in the order gathered
+		 */
+		round_i = LS_CHUNK_ARENA_MAGAZINE_SIZE;
+
+		while (round_i)
+		{
+			if ((chunk_i = _ls_chunk_arena_pop_atomic(chunk_arena)))
+			{
+				magazine->_round_a[--round_i] = LS_CAST(chunk_i, ls_u32_t);
+				continue;
+			}
+
+			bump_c = _ls_chunk_arena_bump_atomic(chunk_arena, round_i, &chunk_i);
+
+			if (!bump_c)
+			{
+				/* a batch reached the depot meanwhile, or a delete is still pushing */
+				bump_c	= 1;
+				chunk_i	= _ls_chunk_arena_take_atomic(chunk_arena);
+			}
+
+			for (; bump_c; bump_c--, chunk_i++)
+			{
+				magazine->_round_a[--round_i] = LS_CAST(chunk_i, ls_u32_t);
+			}
+		}
+
+		magazine->_round_c = LS_CHUNK_ARENA_MAGAZINE_SIZE - 1;
+		return LS_CHUNK_ARENA_INDEX_TO_ADDR(chunk_arena, magazine->_round_a[magazine->_round_c] - 1);
+	}
+
+	/* the batch is ours now: its first chunk is handed out, the rest is loaded */
+	next_i = chunk_arena->_meta[chunk_i - 1]._next;
+
+	while (next_i)
+	{
+		magazine->_round_a[magazine->_round_c++] = LS_CAST(next_i, ls_u32_t);
+		next_i = chunk_arena->_meta[next_i - 1]._next;
+	}
+
+	return LS_CHUNK_ARENA_INDEX_TO_ADDR(chunk_arena, chunk_i - 1);
+}
+
+static LS_INLINE void ls_chunk_arena_magazine_delete_chunk(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_magazine_s *magazine, ls_void_p chunk_p)
+{
+	chunk_arena->_meta[LS_CHUNK_ARENA_ADDR_TO_INDEX(chunk_arena, chunk_p)]._gen++;
+
+	if (magazine->_round_c == LS_CHUNK_ARENA_MAGAZINE_SIZE * 2)
+	{
+		/* the older half goes to the depot, the recently deleted (cache hot) half stays */
+		_ls_chunk_arena_depot_give(chunk_arena, magazine->_round_a);
+
+		LS_MEMCPY(magazine->_round_a, magazine->_round_a + LS_CHUNK_ARENA_MAGAZINE_SIZE, LS_CHUNK_ARENA_MAGAZINE_SIZE * sizeof(ls_u32_t));
+		magazine->_round_c = LS_CHUNK_ARENA_MAGAZINE_SIZE;
+	}
+
+	magazine->_round_a[magazine->_round_c++] = LS_CAST(LS_CHUNK_ARENA_ADDR_TO_INDEX(chunk_arena, chunk_p) + 1, ls_u32_t);
+}
+
+static LS_INLINE void ls_chunk_arena_magazine_flush(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_magazine_s *magazine)
+{
+	while (magazine->_round_c >= LS_CHUNK_ARENA_MAGAZINE_SIZE)
+	{
+		magazine->_round_c -= LS_CHUNK_ARENA_MAGAZINE_SIZE;
+		_ls_chunk_arena_depot_give(chunk_arena, magazine->_round_a + magazine->_round_c);
+	}
+
+	while (magazine->_round_c)
+	{
+		magazine->_round_c--;
+		ls_chunk_arena_delete_chunk_atomic(chunk_arena, LS_CHUNK_ARENA_INDEX_TO_ADDR(chunk_arena, magazine->_round_a[magazine->_round_c] - 1));
+	}
+}
+
+
+
+static LS_INLINE void ls_chunk_arena_epoch_register(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_epoch_s *epoch)
+{
+	LS_MEMSET(epoch, 0, sizeof(*epoch));
+
+	epoch->_next = __atomic_load_n(&chunk_arena->_epoch_list, __ATOMIC_RELAXED);
+
+	while (!__atomic_compare_exchange_n(&chunk_arena->_epoch_list, &epoch->_next, epoch, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+static LS_INLINE void ls_chunk_arena_epoch_enter(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_epoch_s *epoch)
+{
+	__atomic_store_n(&epoch->_local, (__atomic_load_n(&chunk_arena->_epoch, __ATOMIC_RELAXED) << 1) | 1, __ATOMIC_RELAXED);
+
+	/* the announcement must be visible before any shared chunk is read */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static LS_INLINE void ls_chunk_arena_epoch_exit(ls_chunk_arena_epoch_s *epoch)
+{
+	__atomic_store_n(&epoch->_local, 0, __ATOMIC_RELEASE);
+}
+
+static LS_INLINE void ls_chunk_arena_epoch_retire(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_epoch_s *epoch, ls_void_p chunk_p)
+{
+	ls_u64_t chunk_i	= LS_CHUNK_ARENA_ADDR_TO_INDEX(chunk_arena, chunk_p);
+	ls_u64_t now;
+	ls_u64_t limbo_i;
+
+	/*
+	 * tagged with the global epoch, not the one the critical section was entered in: a thread
+	 * descheduled inside enter announces a stale epoch, which holds the epoch back but must not
+	 * date chunks retired later
+	 */
+	now		= __atomic_load_n(&chunk_arena->_epoch, __ATOMIC_SEQ_CST);
+	limbo_i	= now % LS_CHUNK_ARENA_EPOCH_LIMBO_C;
+
+	/* the list was filled LS_CHUNK_ARENA_EPOCH_LIMBO_C or more epochs ago, long safe */
+	if (epoch->_limbo_a[limbo_i] && epoch->_limbo_epoch_a[limbo_i] != now)
+	{
+		_ls_chunk_arena_epoch_free(chunk_arena, epoch, limbo_i);
+	}
+
+	if (!epoch->_limbo_a[limbo_i])
+	{
+		epoch->_limbo_last_a[limbo_i]	= LS_CAST(chunk_i + 1, ls_u32_t);
+		epoch->_limbo_epoch_a[limbo_i]	= now;
+	}
+
+	chunk_arena->_meta[chunk_i]._next	= epoch->_limbo_a[limbo_i];
+	epoch->_limbo_a[limbo_i]			= LS_CAST(chunk_i + 1, ls_u32_t);
+
+	if (!(++epoch->_op_c % LS_CHUNK_ARENA_EPOCH_PERIOD))
+	{
+		ls_chunk_arena_epoch_reclaim(chunk_arena, epoch);
+	}
+}
+
+static LS_INLINE ls_void_p ls_chunk_arena_epoch_get_chunk(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_epoch_s *epoch, ls_result_t *status)
+{
+	ls_void_p chunk_p;
+
+	if (!(++epoch->_op_c % LS_CHUNK_ARENA_EPOCH_PERIOD))
+	{
+		ls_chunk_arena_epoch_reclaim(chunk_arena, epoch);
+	}
+
+	chunk_p = ls_chunk_arena_get_chunk_atomic(chunk_arena, status);
+
+	/* advancing the epoch helps threads holding retired chunks even if [epoch] holds none */
+	if (!chunk_p)
+	{
+		ls_chunk_arena_epoch_reclaim(chunk_arena, epoch);
+
+		chunk_p = ls_chunk_arena_get_chunk_atomic(chunk_arena, status);
+	}
+
+	return chunk_p;
+}
+
+static LS_INLINE void ls_chunk_arena_epoch_reclaim(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_epoch_s *epoch)
+{
+	ls_u64_t now = __atomic_load_n(&chunk_arena->_epoch, __ATOMIC_ACQUIRE);
+	ls_chunk_arena_epoch_s *other;
+	ls_u64_t local;
+	ls_u64_t limbo_i;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	for (other = __atomic_load_n(&chunk_arena->_epoch_list, __ATOMIC_ACQUIRE); other; other = other->_next)
+	{
+		local = __atomic_load_n(&other->_local, __ATOMIC_ACQUIRE);
+
+		if ((local & 1) && (local >> 1) != now)
+		{
+			break;
+		}
+	}
+
+	/* every critical section still open was entered in [now], a failed exchange means another thread advanced it */
+	if (!other)
+	{
+		__atomic_compare_exchange_n(&chunk_arena->_epoch, &now, now + 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+	}
+
+	now = __atomic_load_n(&chunk_arena->_epoch, __ATOMIC_ACQUIRE);
+
+	for (limbo_i = 0; limbo_i < LS_CHUNK_ARENA_EPOCH_LIMBO_C; limbo_i++)
+	{
+		if (epoch->_limbo_a[limbo_i] && epoch->_limbo_epoch_a[limbo_i] + 2 <= now)
+		{
+			_ls_chunk_arena_epoch_free(chunk_arena, epoch, limbo_i);
+		}
+	}
+}
+
+/* pushes limbo list [limbo_i] of [epoch] onto the free stack at once */
+static LS_INLINE void _ls_chunk_arena_epoch_free(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_epoch_s *epoch, ls_u64_t limbo_i)
+{
+	ls_u32_t trim_c					= LS_CAST(__atomic_load_n(&chunk_arena->_trim_c, __ATOMIC_RELAXED), ls_u32_t);
+	ls_u64_t chunk_i				= epoch->_limbo_a[limbo_i];
+	ls_u64_t chunk_c				= 0;
+	ls_chunk_arena_meta_s *last		= &chunk_arena->_meta[epoch->_limbo_last_a[limbo_i] - 1];
+	ls_chunk_arena_meta_s *meta;
+	ls_u64_t head;
+
+	while (chunk_i)
+	{
+		meta			= &chunk_arena->_meta[chunk_i - 1];
+		meta->_trim_c	= trim_c;
+		meta->_flags	= LS_CHUNK_ARENA_FREE;
+		meta->_gen++;
+
+		chunk_c++;
+		chunk_i = meta->_next;
+	}
+
+	head = __atomic_load_n(&chunk_arena->_last_deleted_chunk, __ATOMIC_RELAXED);
+
+	do
+	{
+		__atomic_store_n(&last->_next, LS_CAST(LS_CHUNK_ARENA_FREE_INDEX(head), ls_u32_t), __ATOMIC_RELAXED);
+	}
+	while (!__atomic_compare_exchange_n(&chunk_arena->_last_deleted_chunk, &head, LS_CHUNK_ARENA_FREE_WORD(epoch->_limbo_a[limbo_i], LS_CHUNK_ARENA_FREE_TAG(head) + 1),
+		1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+	__atomic_fetch_sub(&chunk_arena->_chunk_c, chunk_c, __ATOMIC_RELEASE);
+	_LS_CHUNK_ARENA_COUNT_ATOMIC(chunk_arena, _delete_c, chunk_c);
+
+	epoch->_limbo_a[limbo_i] = 0;
+}
+
+/* whether any registered thread holds retired chunks */
+static LS_INLINE ls_bool_t _ls_chunk_arena_epoch_pending(ls_chunk_arena_s *chunk_arena)
+{
+	ls_chunk_arena_epoch_s *epoch;
+	ls_u64_t limbo_i;
+
+	for (epoch = chunk_arena->_epoch_list; epoch; epoch = epoch->_next)
+	{
+		for (limbo_i = 0; limbo_i < LS_CHUNK_ARENA_EPOCH_LIMBO_C; limbo_i++)
+		{
+			if (epoch->_limbo_a[limbo_i])
+			{
+				return LS_TRUE;
+			}
+		}
+	}
+
+	return LS_FALSE;
+}
+
+
+/* plain loads only, the fields may be a little out of step with each other while _atomic functions run */
+static LS_INLINE void ls_chunk_arena_stats(ls_chunk_arena_s *chunk_arena, ls_chunk_arena_stats_s *stats)
+{
+	stats->live_c			= __atomic_load_n(&chunk_arena->_chunk_c, __ATOMIC_RELAXED);
+	stats->high_water_c		= __atomic_load_n(&chunk_arena->_next_committed_chunk, __ATOMIC_RELAXED) - 1;
+	stats->committed_c		= __atomic_load_n(&chunk_arena->_committed_chunk_c, __ATOMIC_RELAXED);
+	stats->free_c			= (stats->high_water_c > stats->live_c) ? stats->high_water_c - stats->live_c : 0;
+	stats->get_c			= __atomic_load_n(&chunk_arena->_get_c, __ATOMIC_RELAXED);
+	stats->delete_c			= __atomic_load_n(&chunk_arena->_delete_c, __ATOMIC_RELAXED);
+	stats->commit_call_c	= __atomic_load_n(&chunk_arena->_commit_call_c, __ATOMIC_RELAXED);
+	stats->fragmentation	= stats->committed_c ? LS_CAST(stats->free_c, ls_f64_t) / LS_CAST(stats->committed_c, ls_f64_t) : 0.0;
+}
+
+
+static LS_INLINE void ls_chunk_arena_family_init(ls_chunk_arena_family_s *family, ls_void_p memory, ls_u64_t memory_size, ls_u64_t const *chunk_size_a, ls_u64_t class_c)
+{
+	ls_u64_t block_size	= chunk_size_a[class_c - 1];
+	ls_u64_t slot_c		= block_size / chunk_size_a[0];
+	ls_u64_t block_c;
+	ls_u64_t i;
+
+	/* a block, its metadata in the arena, its bookkeeping and its links */
+	block_c	= memory_size / (block_size + sizeof(ls_chunk_arena_meta_s) + sizeof(ls_chunk_arena_block_s) + slot_c * sizeof(ls_u32_t));
+	block_c	= (block_c > LS_CHUNK_ARENA_MAX_CHUNK_C) ? LS_CHUNK_ARENA_MAX_CHUNK_C : block_c;
+
+	family->_block		= ls_chunk_arena_init(memory, block_c * (block_size + sizeof(ls_chunk_arena_meta_s)), block_size);
+	family->_block_meta	= LS_CAST(LS_CAST(memory, ls_u8_p) + block_c * (block_size + sizeof(ls_chunk_arena_meta_s)), ls_chunk_arena_block_s *);
+	family->_link_a		= LS_CAST(family->_block_meta + block_c, ls_u32_p);
+	family->_slot_c		= slot_c;
+	family->_class_c	= class_c;
+
+	_LS_CHUNK_ARENA_COMMIT(&family->_block, block_c * (block_size + sizeof(ls_chunk_arena_meta_s)), block_c * sizeof(ls_chunk_arena_block_s));
+
+	for (i = 0; i < class_c; i++)
+	{
+		family->_chunk_size_a[i]	= chunk_size_a[i];
+		family->_partial_a[i]		= 0;
+	}
+}
+
+static LS_INLINE void ls_chunk_arena_family_fini(ls_chunk_arena_family_s *family)
+{
+	ls_chunk_arena_fini(&family->_block);
+
+	family->_class_c = 0;
+}
+
+static LS_INLINE ls_void_p ls_chunk_arena_family_get_chunk(ls_chunk_arena_family_s *family, ls_u64_t size, ls_result_t *status)
+{
+	ls_u64_t class_i = _ls_chunk_arena_family_class(family, size);
+	ls_chunk_arena_block_s *block;
+	ls_u64_t block_i;
+	ls_u64_t chunk_i;
+	ls_u8_p	 block_p;
+
+	if (class_i == family->_class_c)
+	{
+		*status = LS_CHUNK_ARENA_TOO_LARGE;
+		return LS_NULL;
+	}
+
+	if (class_i == family->_class_c - 1 || !family->_partial_a[class_i])
+	{
+		block_p = LS_CAST(ls_chunk_arena_get_chunk(&family->_block, status), ls_u8_p);
+
+		if (block_p == LS_NULL)
+		{
+			return LS_NULL;
+		}
+
+		block_i = LS_CHUNK_ARENA_ADDR_TO_INDEX((&family->_block), block_p);
+		block	= _ls_chunk_arena_family_block(family, block_i);
+
+		block->_class_i	= LS_CAST(class_i, ls_u32_t);
+
+		if (class_i == family->_class_c - 1)
+		{
+			return block_p;
+		}
+
+		block->_used_c	= 0;
+		block->_free_i	= 0;
+		block->_bump_i	= 0;
+		block->_prev	= 0;
+		block->_next	= 0;
+
+		_LS_CHUNK_ARENA_COMMIT(&family->_block, LS_CAST(LS_CAST(family->_link_a + block_i * family->_slot_c, ls_u8_p) - LS_CAST(family->_block._memory, ls_u8_p), ls_u64_t),
+			family->_block._chunk_size / family->_chunk_size_a[class_i] * sizeof(ls_u32_t));
+
+		family->_partial_a[class_i] = LS_CAST(block_i + 1, ls_u32_t);
+	}
+
+	*status = LS_SUCCESS;
+
+	block_i = family->_partial_a[class_i] - 1;
+	block	= _ls_chunk_arena_family_block(family, block_i);
+	block_p	= LS_CAST(LS_CHUNK_ARENA_INDEX_TO_ADDR((&family->_block), block_i), ls_u8_p);
+
+	if (block->_free_i)
+	{
+		chunk_i			= block->_free_i - 1;
+		block->_free_i	= family->_link_a[block_i * family->_slot_c + chunk_i];
+	}
+	else
+	{
+		chunk_i = block->_bump_i++;
+	}
+
+	/* a full block leaves the list until one of its chunks is deleted */
+	if (++block->_used_c == family->_block._chunk_size / family->_chunk_size_a[class_i])
+	{
+		_ls_chunk_arena_family_unlink(family, block_i);
+	}
+
+	return block_p + chunk_i * family->_chunk_size_a[class_i];
+}
+
+static LS_INLINE void ls_chunk_arena_family_delete_chunk(ls_chunk_arena_family_s *family, ls_void_p chunk_p)
+{
+	ls_u64_t offset = LS_CAST(chunk_p, ls_u64_t) - LS_CAST(family->_block._memory, ls_u64_t);
+	ls_u64_t block_i = offset / family->_block._chunk_size;
+	ls_chunk_arena_block_s *block = _ls_chunk_arena_family_block(family, block_i);
+	ls_u64_t chunk_size;
+	ls_u64_t chunk_i;
+
+	if (block->_class_i == family->_class_c - 1)
+	{
+		ls_chunk_arena_delete_chunk(&family->_block, chunk_p);
+		return;
+	}
+
+	chunk_size	= family->_chunk_size_a[block->_class_i];
+	chunk_i		= (offset % family->_block._chunk_size) / chunk_size;
+
+	if (block->_used_c == family->_block._chunk_size / chunk_size)
+	{
+		block->_prev = 0;
+		block->_next = family->_partial_a[block->_class_i];
+
+		if (block->_next)
+		{
+			_ls_chunk_arena_family_block(family, block->_next - 1)->_prev = LS_CAST(block_i + 1, ls_u32_t);
+		}
+
+		family->_partial_a[block->_class_i] = LS_CAST(block_i + 1, ls_u32_t);
+	}
+
+	if (--block->_used_c == 0)
+	{
+		/* empty, any class may take it now */
+		_ls_chunk_arena_family_unlink(family, block_i);
+		ls_chunk_arena_delete_chunk(&family->_block, LS_CHUNK_ARENA_INDEX_TO_ADDR((&family->_block), block_i));
+		return;
+	}
+
+	family->_link_a[block_i * family->_slot_c + chunk_i]	= block->_free_i;
+	block->_free_i											= LS_CAST(chunk_i + 1, ls_u32_t);
+}
+
+static LS_INLINE ls_u64_t ls_chunk_arena_family_chunk_size(ls_chunk_arena_family_s *family, ls_void_p chunk_p)
+{
+	ls_u64_t offset = LS_CAST(chunk_p, ls_u64_t) - LS_CAST(family->_block._memory, ls_u64_t);
+
+	return family->_chunk_size_a[_ls_chunk_arena_family_block(family, offset / family->_block._chunk_size)->_class_i];
+}
+
+static LS_INLINE void ls_chunk_arena_family_trim(ls_chunk_arena_family_s *family, ls_u64_t idle_c)
+{
+	ls_chunk_arena_trim(&family->_block, idle_c);
+}
+
+/* the smallest class with chunks of at least [size] bytes, [_class_c] if there is none */
+static LS_INLINE ls_u64_t _ls_chunk_arena_family_class(ls_chunk_arena_family_s *family, ls_u64_t size)
+{
+	ls_u64_t i = 0;
+
+	while (i < family->_class_c && family->_chunk_size_a[i] < size)
+	{
+		i++;
+	}
+
+	return i;
+}
+
+static LS_INLINE ls_chunk_arena_block_s *_ls_chunk_arena_family_block(ls_chunk_arena_family_s *family, ls_u64_t block_i)
+{
+	return &family->_block_meta[block_i];
+}
+
+/* takes block [block_i] off the list of its class */
+static LS_INLINE void _ls_chunk_arena_family_unlink(ls_chunk_arena_family_s *family, ls_u64_t block_i)
+{
+	ls_chunk_arena_block_s *block = _ls_chunk_arena_family_block(family, block_i);
+
+	if (block->_prev)
+	{
+		_ls_chunk_arena_family_block(family, block->_prev - 1)->_next = block->_next;
+	}
+	else
+	{
+		family->_partial_a[block->_class_i] = block->_next;
+	}
+
+	if (block->_next)
+	{
+		_ls_chunk_arena_family_block(family, block->_next - 1)->_prev = block->_prev;
+	}
+
+	block->_prev = 0;
+	block->_next = 0;
+}
+
+
+static LS_INLINE void ls_chunk_arena_numa_init(ls_chunk_arena_numa_s *numa, ls_void_p memory, ls_u64_t memory_size, ls_u64_t chunk_size, ls_u64_t node_c)
+{
+	ls_u64_t align	= chunk_size;
+	ls_u64_t i;
+	ls_u8_p region;
+
+	#ifdef __linux__
+		/* mbind takes whole pages, a page bound to two nodes would go to the last */
+		align = (LS_CAST(sysconf(_SC_PAGESIZE), ls_u64_t) > chunk_size) ? LS_CAST(sysconf(_SC_PAGESIZE), ls_u64_t) : chunk_size;
+	#endif
+
+	node_c = node_c ? node_c : 1;
+	node_c = (node_c > LS_CHUNK_ARENA_NUMA_MAX_NODE_C) ? LS_CHUNK_ARENA_NUMA_MAX_NODE_C : node_c;
+
+	numa->_memory		= memory;
+	numa->_region_size	= LS_ROUND_DOWN_TO(memory_size / node_c, align);
+	numa->_node_c		= node_c;
+
+	for (i = 0; i < node_c; i++)
+	{
+		region = LS_CAST(memory, ls_u8_p) + i * numa->_region_size;
+
+		/* before anything is committed, so every page of the region is faulted in on its node */
+		_ls_chunk_arena_numa_bind(region, numa->_region_size, i);
+
+		numa->_node_a[i] = ls_chunk_arena_init(region, numa->_region_size, chunk_size);
+	}
+}
+
+static LS_INLINE void ls_chunk_arena_numa_fini(ls_chunk_arena_numa_s *numa)
+{
+	ls_u64_t i;
+
+	for (i = 0; i < numa->_node_c; i++)
+	{
+		ls_chunk_arena_fini(&numa->_node_a[i]);
+	}
+
+	numa->_memory		= LS_NULL;
+	numa->_region_size	= 0;
+	numa->_node_c		= 0;
+}
+
+static LS_INLINE ls_void_p ls_chunk_arena_numa_get_chunk(ls_chunk_arena_numa_s *numa, ls_result_t *status)
+{
+	ls_u64_t node = LS_CHUNK_ARENA_NUMA_NODE() % numa->_node_c;
+	ls_void_p chunk_p;
+	ls_u64_t i;
+
+	/* remote memory is still better than none, the nearest nodes are not known so go in order */
+	for (i = 0; i < numa->_node_c; i++)
+	{
+		chunk_p = ls_chunk_arena_get_chunk_atomic(&numa->_node_a[(node + i) % numa->_node_c], status);
+
+		if (*status == LS_SUCCESS)
+		{
+			return chunk_p;
+		}
+	}
+
+	return LS_NULL;
+}
+
+static LS_INLINE void ls_chunk_arena_numa_delete_chunk(ls_chunk_arena_numa_s *numa, ls_void_p chunk_p)
+{
+	ls_chunk_arena_delete_chunk_atomic(&numa->_node_a[ls_chunk_arena_numa_node_of(numa, chunk_p)], chunk_p);
+}
+
+static LS_INLINE ls_u64_t ls_chunk_arena_numa_node_of(ls_chunk_arena_numa_s *numa, ls_void_p chunk_p)
+{
+	return (LS_CAST(chunk_p, ls_u64_t) - LS_CAST(numa->_memory, ls_u64_t)) / numa->_region_size;
+}
+
+static LS_INLINE ls_u64_t _ls_chunk_arena_numa_node(void)
+{
+	#if defined(__linux__) && defined(SYS_getcpu)
+		unsigned int cpu;
+		unsigned int node;
+
+		if (syscall(SYS_getcpu, &cpu, &node, LS_NULL) == 0)
+		{
+			return node;
+		}
+	#endif
+
+	return 0;
+}
+
+/* best effort: on hosts without [node] or without mbind the region is placed as usual */
+static LS_INLINE void _ls_chunk_arena_numa_bind(ls_void_p memory, ls_u64_t size, ls_u64_t node)
+{
+	#if defined(__linux__) && defined(SYS_mbind)
+		unsigned long nodemask[16] = { 0 };  /* up to 1024 nodes */
+
+		if (node >= sizeof(nodemask) * 8)
+		{
+			return;
+		}
+
+		nodemask[node / (sizeof(unsigned long) * 8)] |= 1ul << (node % (sizeof(unsigned long) * 8));
+
+		/* 1: MPOL_PREFERRED, falls back to other nodes instead of failing */
+		syscall(SYS_mbind, memory, size, 1, nodemask, sizeof(nodemask) * 8, 0);
+	#else
+		(void) memory;
+		(void) size;
+		(void) node;
+	#endif
+}
+
+
+#ifdef LS_CHUNK_ARENA_USE_VALLOC
+
+static LS_INLINE ls_result_t ls_chunk_arena_grow_init(ls_chunk_arena_grow_s *grow, ls_u64_t chunk_size)
+{
+	grow->_segment_c	= 0;
+	grow->_chunk_size	= chunk_size;
+	grow->_hint			= 0;
+
+	return _ls_chunk_arena_grow_segment(grow);
+}
+
+static LS_INLINE void ls_chunk_arena_grow_fini(ls_chunk_arena_grow_s *grow)
+{
+	ls_u64_t i;
+
+	for (i = 0; i < grow->_segment_c; i++)
+	{
+		ls_chunk_arena_fini(&grow->_segment_a[i]);
+		ls_valloc_vfree(grow->_reserve_a[i]);
+	}
+
+	grow->_segment_c	= 0;
+	grow->_chunk_size	= 0;
+	grow->_hint			= 0;
+}
+
+static LS_INLINE ls_void_p ls_chunk_arena_grow_get_chunk(ls_chunk_arena_grow_s *grow, ls_result_t *status)
+{
+	ls_void_p chunk_p;
+
+	for (;;)
+	{
+		/* a full segment fails in O(1), so walking past them is cheap */
+		for (; grow->_hint < grow->_segment_c; grow->_hint++)
+		{
+			chunk_p = ls_chunk_arena_get_chunk(&grow->_segment_a[grow->_hint], status);
+
+			if (*status == LS_SUCCESS)
+			{
+				return chunk_p;
+			}
+		}
+
+		if (_ls_chunk_arena_grow_segment(grow) != LS_SUCCESS)
+		{
+			*status = LS_CHUNK_ARENA_MEM_FULL;
+			return LS_NULL;
+		}
+	}
+}
+
+static LS_INLINE void ls_chunk_arena_grow_delete_chunk(ls_chunk_arena_grow_s *grow, ls_void_p chunk_p)
+{
+	ls_chunk_arena_s *segment;
+	ls_u64_t i;
+
+	for (i = 0; i < grow->_segment_c; i++)
+	{
+		segment = &grow->_segment_a[i];
+
+		if (LS_CAST(chunk_p, ls_u64_t) - LS_CAST(segment->_memory, ls_u64_t) < segment->_max_chunk_c * segment->_chunk_size)
+		{
+			ls_chunk_arena_delete_chunk(segment, chunk_p);
+
+			grow->_hint = (i < grow->_hint) ? i : grow->_hint;
+			return;
+		}
+	}
+}
+
+static LS_INLINE void ls_chunk_arena_grow_trim(ls_chunk_arena_grow_s *grow, ls_u64_t idle_c)
+{
+	ls_u64_t i;
+
+	for (i = 0; i < grow->_segment_c; i++)
+	{
+		ls_chunk_arena_trim(&grow->_segment_a[i], idle_c);
+	}
+}
+
+/* reserves one more segment and hands it to a fresh arena, LS_FAIL once the address space or LS_CHUNK_ARENA_SEGMENT_MAX_C runs out */
+static LS_INLINE ls_result_t _ls_chunk_arena_grow_segment(ls_chunk_arena_grow_s *grow)
+{
+	ls_void_p reserve;
+	ls_u64_t size;
+	ls_u64_t start;
+
+	if (grow->_segment_c == LS_CHUNK_ARENA_SEGMENT_MAX_C)
+	{
+		return LS_FAIL;
+	}
+
+	reserve = ls_valloc_vmalloc(&size);
+
+	if (reserve == LS_NULL)
+	{
+		return LS_FAIL;
+	}
+
+	start = LS_ROUND_UP_TO(LS_CAST(reserve, ls_u64_t), grow->_chunk_size);
+	size  = LS_ROUND_DOWN_TO(size - (start - LS_CAST(reserve, ls_u64_t)), grow->_chunk_size);
+
+	grow->_reserve_a[grow->_segment_c] = reserve;
+	grow->_segment_a[grow->_segment_c] = ls_chunk_arena_init(LS_CAST(start, ls_void_p), size, grow->_chunk_size);
+	grow->_segment_c++;
+
+	return LS_SUCCESS;
+}
+
+#endif
+
+
 #endif  /* #ifndef LS_CHUNK_ARENA_H */
 
 
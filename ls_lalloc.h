@@ -1,5 +1,5 @@
 /*
- * ls_valloc.h - v1.0 - layered memory allocator - Logan Seeley 2026
+ * ls_valloc.h - v1.1 - layered memory allocator - Logan Seeley 2026
  *
  * Overview
  *
@@ -62,6 +62,14 @@
  *  void lfree(mem)
  *      Frees [mem]. [mem] must be returned
  *      by [lalloc] or [relalloc].
+ *
+ *  u64 lalloc_usable_size(void* mem)
+ *      Returns the size of the block behind
+ *      [mem], the size it was allocated with
+ *      rounded up. All of it may be used, so
+ *      growing within it needs no [relalloc].
+ *      [mem] must be returned by [lalloc] or
+ *      [relalloc].
  */
 
 
@@ -81,6 +89,7 @@
     #define lalloc      ls_lalloc
     #define relalloc    ls_relalloc
     #define lfree       ls_lfree
+    #define lalloc_usable_size ls_lalloc_usable_size
 #endif
 
 
@@ -88,9 +97,18 @@
 
     /* API */
 
-    extern void* ls_lalloc  (ls_u64_t size);
-    extern void* ls_relalloc(void*    mem, ls_u64_t size);
-    extern void  ls_lfree   (void*    mem);
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+
+    extern void*    ls_lalloc            (ls_u64_t size);
+    extern void*    ls_relalloc          (void*    mem, ls_u64_t size);
+    extern void     ls_lfree             (void*    mem);
+    extern ls_u64_t ls_lalloc_usable_size(void*    mem);
+
+    #ifdef __cplusplus
+    }
+    #endif
 
 #else
 
@@ -161,6 +179,8 @@ void* ls_lalloc     (ls_u64_t size);
 void* ls_relalloc   (void*    mem, ls_u64_t size);
 void  ls_lalloc_free(void*    mem);
 
+ls_u64_t ls_lalloc_usable_size(void* mem);
+
 static void* ls_lalloc_layer_get_spot_    (ls_u8_t layer_i);
 static void* ls_lalloc_layer_get_del_spot_(ls_u8_t layer_i);
 static void  ls_lalloc_layer_del_spot_    (ls_u8_t layer_i, void* spot);
@@ -265,7 +285,9 @@ void* ls_relalloc(void* mem, ls_u64_t size)
 
     void* spot = ls_lalloc_layer_get_spot_(new_layer_i);
 
-    if (ls_lalloc_meta_.header_a[new_layer_i].block_z < LS_LALLOC_MEMCPY_THRES)
+    /* blocks below page size are not page aligned and cannot be remapped */
+    if (ls_lalloc_meta_.header_a[new_layer_i].block_z < LS_LALLOC_MEMCPY_THRES ||
+        ls_lalloc_meta_.header_a[old_layer_i].block_z < ls_lalloc_meta_.page_z)
     {
         #if defined(LS_WINDOWS_OS)
             #warning "incomplete windows implementation"
@@ -289,8 +311,9 @@ void* ls_relalloc(void* mem, ls_u64_t size)
             mremap(mem, LS_HEADER_TMP_.block_z, LS_HEADER_TMP_.block_z,
                 MREMAP_FIXED | MREMAP_MAYMOVE | MREMAP_DONTUNMAP, spot);
 
+            /* the new block may be more than twice the old one */
             mprotect(LS_PARITHM(spot) + LS_HEADER_TMP_.block_z,
-                LS_HEADER_TMP_.block_z, PROT_READ | PROT_WRITE);
+                block_z - LS_HEADER_TMP_.block_z, PROT_READ | PROT_WRITE);
             
             mprotect(mem,
                 ls_lalloc_meta_.page_z, PROT_READ | PROT_WRITE);
@@ -316,6 +339,14 @@ void ls_lfree(void* mem)
     ls_lalloc_spinunlock_();
 }
 
+ls_u64_t ls_lalloc_usable_size(void* mem)
+{
+    ls_u8_t layer_i = LS_CAST(LS_PARITHM(mem) - LS_PARITHM(ls_lalloc_meta_.vspace_p), ls_u64_t) / LS_LALLOC_LAYER_Z_;
+
+    /* block sizes of layers never change, no need to lock */
+    return LS_LALLOC_MIN_Z_ << layer_i;
+}
+
 
 static LS_INLINE void* ls_lalloc_layer_get_spot_(ls_u8_t layer_i)
 {
@@ -25,6 +25,11 @@
 
 	typedef ls_u32_t	ls_result_t;
 
+	typedef void	   *ls_void_p;
+	typedef ls_u8_t	   *ls_u8_p;
+	typedef ls_u32_t   *ls_u32_p;
+	typedef ls_u64_t   *ls_u64_p;
+
 	#define LS_NULL		LS_CAST(0, void *)
 
 #endif
@@ -0,0 +1,390 @@
+/*
+ * ls_object_pool.h - v1.0.0 - fixed size object pool - Logan Seeley 2025
+ *
+ * Documentation
+ *
+ *	Behaviour & Safety
+ *
+ *		A pool hands out slots of one size, carved from chunks of an
+ *		[ls_chunk_arena_s]. Every chunk begins with a small header
+ *		holding its occupancy bitmap and free slot count, the slots
+ *		follow aligned to the requested alignment. Since arena chunks
+ *		are aligned to their size, the chunk of a slot is found by
+ *		masking the slot's address, so freeing needs no lookup.
+ *
+ *		Chunks with free slots are kept on a list, full chunks on
+ *		another. A chunk whose slots are all freed is given back to
+ *		the arena unless it is the only chunk with free slots left.
+ *
+ *		The lifetime of any [ls_object_pool_s] must be less than
+ *		that of its arena. A pool uses the non _atomic functions of
+ *		the arena and must be locked along with it.
+ *
+ *	Usage
+ *
+ *		Include [ls_chunk_arena.h] (and define its allocator binding)
+ *		before including this file.
+ *
+ *		From C++, [ls::object_pool<T>] wraps a pool for objects of type T.
+ *
+ *	Functions
+ *
+ *		ls_object_pool_s ls_object_pool_init(ls_chunk_arena_s *chunk_arena, ls_u64_t object_size, ls_u64_t object_align) - pool_init
+ *			[object_align] must be a power of 2, [object_size] is rounded up to it.
+ *			At least one slot must fit into a chunk after the header.
+ *
+ *		void ls_object_pool_fini(ls_object_pool_s *pool) - pool_fini
+ *			gives every chunk back to the arena, live slots included.
+ *
+ *		ls_void_p ls_object_pool_alloc(ls_object_pool_s *pool, ls_result_t *status) - pool_alloc
+ *			returns the lowest free slot of the first chunk with free slots.
+ *			[status] is out
+ *			[*status] = LS_SUCCESS
+ *			[*status] = LS_CHUNK_ARENA_MEM_FULL -> no free slot and the arena is full. [return] will also be LS_NULL
+ *
+ *		void ls_object_pool_free(ls_object_pool_s *pool, ls_void_p slot_p) - pool_free
+ *			[slot_p] must have been returned by [ls_object_pool_alloc] of [pool]
+ *
+ *	C++
+ *
+ *		ls::object_pool<T>(ls_chunk_arena_s *chunk_arena)
+ *			a pool of sizeof(T) slots aligned to alignof(T). Not copyable.
+ *			The destructor gives all chunks back without destroying live objects.
+ *
+ *		T *construct(Args &&...args)
+ *			allocates a slot and constructs T in it, nullptr if the arena is full.
+ *			If the constructor throws, the slot is freed again.
+ *
+ *		void destroy(T *object)
+ *			destroys [object] and frees its slot, does nothing for nullptr.
+ *
+ *		T *allocate() / void deallocate(T *object)
+ *			raw slots, no construction or destruction.
+ */
+
+
+#ifndef LS_OBJECT_POOL_H
+#define LS_OBJECT_POOL_H
+
+
+#include "./ls_macros.h"
+
+#ifndef LS_CHUNK_ARENA_H
+    #error "ls_object_pool.h requires ls_chunk_arena.h to be included first"
+#endif
+
+
+#define LS_OBJECT_POOL_CHUNK_OF(pool, slot_p) (LS_CAST(LS_CAST(slot_p, ls_u64_t) & ~((pool)->_chunk_arena->_chunk_size - 1), ls_object_pool_chunk_s *))
+#define LS_OBJECT_POOL_USED_A(chunk) (LS_CAST((chunk) + 1, ls_u64_p))  /* occupancy bitmap, right past the header */
+
+
+/* header at the start of every chunk of a pool */
+typedef struct ls_object_pool_chunk_s
+{
+	struct ls_object_pool_chunk_s *_next;
+	struct ls_object_pool_chunk_s *_prev;
+
+	ls_u32_t	_free_c;
+	ls_u32_t	_word_i;  /* no free slot in words before it */
+}
+ls_object_pool_chunk_s;
+
+
+typedef struct
+{
+	ls_chunk_arena_s *_chunk_arena;
+
+	ls_u64_t	_slot_size;
+	ls_u64_t	_slot_c;		/* per chunk */
+	ls_u64_t	_slot_offset;	/* of the first slot into a chunk */
+	ls_u64_t	_word_c;		/* of the occupancy bitmap, bits past [_slot_c] are set */
+
+	ls_object_pool_chunk_s *_partial;  /* chunks with free slots */
+	ls_object_pool_chunk_s *_full;
+}
+ls_object_pool_s;
+
+
+static ls_object_pool_s	ls_object_pool_init			(ls_chunk_arena_s 		*chunk_arena, 	ls_u64_t 				 object_size, 	ls_u64_t object_align)	LS_LIBFN;
+static void				ls_object_pool_fini			(ls_object_pool_s 		*pool)																	LS_LIBFN;
+
+static ls_void_p		ls_object_pool_alloc		(ls_object_pool_s 		*pool, 			ls_result_t 			*status)								LS_LIBFN;
+static void				ls_object_pool_free			(ls_object_pool_s 		*pool, 			ls_void_p 				 slot_p)								LS_LIBFN;
+
+static void				_ls_object_pool_link		(ls_object_pool_chunk_s **head, 		ls_object_pool_chunk_s 	*chunk)									LS_LIBFN;
+static void				_ls_object_pool_unlink		(ls_object_pool_chunk_s **head, 		ls_object_pool_chunk_s 	*chunk)									LS_LIBFN;
+
+
+static LS_INLINE ls_object_pool_s ls_object_pool_init(ls_chunk_arena_s *chunk_arena, ls_u64_t object_size, ls_u64_t object_align)
+{
+	ls_object_pool_s pool;
+	ls_u64_t chunk_size = chunk_arena->_chunk_size;
+
+	pool._chunk_arena	= chunk_arena;
+	pool._slot_size		= LS_ROUND_UP_TO(object_size ? object_size : 1, object_align);
+	pool._slot_c		= (chunk_size - sizeof(ls_object_pool_chunk_s)) / pool._slot_size;
+
+	/* the bitmap shrinks along with the slots, so take slots off until both fit */
+	for (;;)
+	{
+		pool._word_c		= (pool._slot_c + 63) / 64;
+		pool._slot_offset	= LS_ROUND_UP_TO(sizeof(ls_object_pool_chunk_s) + pool._word_c * sizeof(ls_u64_t), object_align);
+
+		if (pool._slot_offset + pool._slot_c * pool._slot_size <= chunk_size)
+		{
+			break;
+		}
+
+		pool._slot_c--;
+	}
+
+	pool._partial	= LS_CAST(LS_NULL, ls_object_pool_chunk_s *);
+	pool._full		= LS_CAST(LS_NULL, ls_object_pool_chunk_s *);
+
+	return pool;
+}
+
+static LS_INLINE void ls_object_pool_fini(ls_object_pool_s *pool)
+{
+	ls_object_pool_chunk_s *chunk;
+
+	while ((chunk = pool->_partial))
+	{
+		pool->_partial = chunk->_next;
+		ls_chunk_arena_delete_chunk(pool->_chunk_arena, chunk);
+	}
+
+	while ((chunk = pool->_full))
+	{
+		pool->_full = chunk->_next;
+		ls_chunk_arena_delete_chunk(pool->_chunk_arena, chunk);
+	}
+}
+
+
+static LS_INLINE ls_void_p ls_object_pool_alloc(ls_object_pool_s *pool, ls_result_t *status)
+{
+	ls_object_pool_chunk_s *chunk = pool->_partial;
+	ls_u64_p used_a;
+	ls_u64_t word_i;
+	ls_u64_t bit_i;
+
+	if (!chunk)
+	{
+		chunk = LS_CAST(ls_chunk_arena_get_chunk(pool->_chunk_arena, status), ls_object_pool_chunk_s *);
+
+		if (!chunk)
+		{
+			return LS_NULL;
+		}
+
+		used_a = LS_OBJECT_POOL_USED_A(chunk);
+
+		LS_MEMSET(used_a, 0, pool->_word_c * sizeof(ls_u64_t));
+
+		if (pool->_slot_c % 64)
+		{
+			used_a[pool->_word_c - 1] = ~0llu << (pool->_slot_c % 64);
+		}
+
+		chunk->_free_c = LS_CAST(pool->_slot_c, ls_u32_t);
+		chunk->_word_i = 0;
+
+		_ls_object_pool_link(&pool->_partial, chunk);
+	}
+	else
+	{
+		*status = LS_SUCCESS;
+	}
+
+	used_a = LS_OBJECT_POOL_USED_A(chunk);
+	word_i = chunk->_word_i;
+
+	while (!~used_a[word_i])
+	{
+		word_i++;
+	}
+
+	bit_i = __builtin_ctzll(~used_a[word_i]);
+
+	used_a[word_i]	|= 1llu << bit_i;
+	chunk->_word_i	 = LS_CAST(word_i, ls_u32_t);
+	chunk->_free_c--;
+
+	if (!chunk->_free_c)
+	{
+		_ls_object_pool_unlink(&pool->_partial, chunk);
+		_ls_object_pool_link(&pool->_full, chunk);
+	}
+
+	return LS_CAST(LS_CAST(chunk, ls_u8_p) + pool->_slot_offset + (word_i * 64 + bit_i) * pool->_slot_size, ls_void_p);
+}
+
+static LS_INLINE void ls_object_pool_free(ls_object_pool_s *pool, ls_void_p slot_p)
+{
+	ls_object_pool_chunk_s *chunk = LS_OBJECT_POOL_CHUNK_OF(pool, slot_p);
+	ls_u64_t slot_i = (LS_CAST(slot_p, ls_u8_p) - LS_CAST(chunk, ls_u8_p) - pool->_slot_offset) / pool->_slot_size;
+
+	LS_OBJECT_POOL_USED_A(chunk)[slot_i / 64] &= ~(1llu << (slot_i % 64));
+
+	if (slot_i / 64 < chunk->_word_i)
+	{
+		chunk->_word_i = LS_CAST(slot_i / 64, ls_u32_t);
+	}
+
+	if (!chunk->_free_c)
+	{
+		_ls_object_pool_unlink(&pool->_full, chunk);
+		_ls_object_pool_link(&pool->_partial, chunk);
+	}
+
+	chunk->_free_c++;
+
+	/* keep the last chunk with free slots around, so one object going back and forth does not churn the arena */
+	if (chunk->_free_c == pool->_slot_c && (chunk->_next || chunk->_prev))
+	{
+		_ls_object_pool_unlink(&pool->_partial, chunk);
+		ls_chunk_arena_delete_chunk(pool->_chunk_arena, chunk);
+	}
+}
+
+
+static LS_INLINE void _ls_object_pool_link(ls_object_pool_chunk_s **head, ls_object_pool_chunk_s *chunk)
+{
+	chunk->_prev = LS_CAST(LS_NULL, ls_object_pool_chunk_s *);
+	chunk->_next = *head;
+
+	if (*head)
+	{
+		(*head)->_prev = chunk;
+	}
+
+	*head = chunk;
+}
+
+static LS_INLINE void _ls_object_pool_unlink(ls_object_pool_chunk_s **head, ls_object_pool_chunk_s *chunk)
+{
+	if (chunk->_prev)
+	{
+		chunk->_prev->_next = chunk->_next;
+	}
+	else
+	{
+		*head = chunk->_next;
+	}
+
+	if (chunk->_next)
+	{
+		chunk->_next->_prev = chunk->_prev;
+	}
+}
+
+
+#ifdef __cplusplus
+
+#include <new>
+#include <utility>
+
+namespace ls
+{
+	template <typename T>
+	class object_pool
+	{
+	public:
+		explicit object_pool(ls_chunk_arena_s *chunk_arena)
+			: _pool(ls_object_pool_init(chunk_arena, sizeof(T), alignof(T)))
+		{
+		}
+
+		~object_pool()
+		{
+			ls_object_pool_fini(&_pool);
+		}
+
+		object_pool(const object_pool &) = delete;
+		object_pool &operator=(const object_pool &) = delete;
+
+		template <typename... Args>
+		T *construct(Args &&...args)
+		{
+			ls_result_t status;
+			void *slot_p = ls_object_pool_alloc(&_pool, &status);
+
+			if (!slot_p)
+			{
+				return nullptr;
+			}
+
+			slot_guard guard = { &_pool, slot_p };
+			T *object = new (slot_p) T(std::forward<Args>(args)...);
+
+			guard._slot_p = nullptr;
+
+			return object;
+		}
+
+		void destroy(T *object)
+		{
+			if (!object)
+			{
+				return;
+			}
+
+			object->~T();
+			ls_object_pool_free(&_pool, object);
+		}
+
+		T *allocate()
+		{
+			ls_result_t status;
+
+			return static_cast<T *>(ls_object_pool_alloc(&_pool, &status));
+		}
+
+		void deallocate(T *object)
+		{
+			ls_object_pool_free(&_pool, object);
+		}
+
+	private:
+		/* frees the slot again if the constructor throws */
+		struct slot_guard
+		{
+			ls_object_pool_s *_pool;
+			void *_slot_p;
+
+			~slot_guard()
+			{
+				if (_slot_p)
+				{
+					ls_object_pool_free(_pool, _slot_p);
+				}
+			}
+		};
+
+		ls_object_pool_s _pool;
+	};
+}
+
+#endif  /* #ifdef __cplusplus */
+
+
+#endif  /* #ifndef LS_OBJECT_POOL_H */
+
+
+/*
+ * Copyright (C) 2025  Logan Seeley
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
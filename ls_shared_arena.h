@@ -0,0 +1,369 @@
+/*
+ * ls_shared_arena.h - v1.0.0 - cross-process chunk arena - Logan Seeley 2025
+ *
+ * Documentation
+ *
+ *	Behaviour & Safety
+ *
+ *		A chunk arena whose state, chunks and free list all live in one shared
+ *		memory object (memfd_create or shm_open), so any number of processes
+ *		can map it, each at its own address, and pass chunks to each other by
+ *		index without copying. Chunks are named by their index only; translate
+ *		it with [ls_shared_arena_addr] in each process.
+ *
+ *		Every function may be called from any amount of threads and processes
+ *		at once: the state is only changed with lock-free atomics on the shared
+ *		header, which work across processes as they are address-free. Like the
+ *		_atomic functions of [ls_chunk_arena_s], the free stack is tagged
+ *		against ABA. A process dying between reserving and taking a chunk
+ *		leaks that chunk, nothing else.
+ *
+ *		The object is sized once at creation. Its pages are only backed once
+ *		touched, chunks never handed out cost nothing. Deleted chunks are kept
+ *		to be reused.
+ *
+ *		Layout of the object: the header rounded up to [chunk_size], then the
+ *		chunks, then a 4 byte link per chunk.
+ *
+ *		Unix only.
+ *
+ *	Functions
+ *
+ *		ls_shared_arena_s ls_shared_arena_create(int fd, ls_u64_t size, ls_u64_t chunk_size, ls_result_t *status) - shared_arena_create
+ *			sizes [fd] to [size] bytes, maps it and sets up an empty arena in it.
+ *			[fd] must be a fresh shared memory object open for reading and writing.
+ *			[chunk_size] must be a power of 2 of at least 16, chunks are aligned to it
+ *			in every process: chunks larger than a page get the object mapped at an
+ *			address aligned to [chunk_size].
+ *			[status] is out
+ *			[*status] = LS_SUCCESS
+ *			[*status] = LS_FAIL -> [fd] could not be sized or mapped, or not even one chunk fits
+ *
+ *		ls_shared_arena_s ls_shared_arena_open(int fd, ls_result_t *status) - shared_arena_open
+ *			maps an arena another process created in [fd], e.g. received over a Unix socket.
+ *			[status] is out
+ *			[*status] = LS_SUCCESS
+ *			[*status] = LS_FAIL -> [fd] could not be mapped or holds no (fully created) arena
+ *
+ *		void ls_shared_arena_close(ls_shared_arena_s *shared_arena) - shared_arena_close
+ *			unmaps the arena in this process. The fd is left open and the
+ *			arena alive for other processes.
+ *
+ *		ls_u32_t ls_shared_arena_get_chunk(ls_shared_arena_s *shared_arena, ls_result_t *status) - shared_arena_get_chunk
+ *			returns the index of a chunk.
+ *			[status] is out
+ *			[*status] = LS_SUCCESS
+ *			[*status] = LS_SHARED_ARENA_MEM_FULL -> could not fetch chunk: none left. [return] will be LS_SHARED_ARENA_NULL_INDEX
+ *
+ *		void ls_shared_arena_delete_chunk(ls_shared_arena_s *shared_arena, ls_u32_t chunk_i) - shared_arena_delete_chunk
+ *			[chunk_i] must have been returned by [ls_shared_arena_get_chunk] in any process.
+ *
+ *		ls_void_p ls_shared_arena_addr(ls_shared_arena_s *shared_arena, ls_u32_t chunk_i) - shared_arena_addr
+ *
+ *		ls_u32_t ls_shared_arena_index(ls_shared_arena_s *shared_arena, ls_void_p chunk_p) - shared_arena_index
+ *			[chunk_p] may point anywhere into the chunk.
+ */
+
+
+#ifndef LS_SHARED_ARENA_H
+#define LS_SHARED_ARENA_H
+
+
+#include "./ls_macros.h"
+
+#ifdef _WIN32
+    #error "ls_shared_arena.h is unix only"
+#endif
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+#define LS_SHARED_ARENA_MEM_FULL	2
+
+#define LS_SHARED_ARENA_NULL_INDEX	0xFFFFFFFFu
+#define LS_SHARED_ARENA_MAX_CHUNK_C	0xFFFFFFFEllu
+
+#define LS_SHARED_ARENA_MAGIC		0x616E657261736Cllu  /* "lsarena" */
+
+/* [_last_deleted_chunk] packs a 1-based chunk index and an ABA tag, like in ls_chunk_arena_s */
+#define LS_SHARED_ARENA_FREE_INDEX(word)		((word) & 0xFFFFFFFFllu)
+#define LS_SHARED_ARENA_FREE_TAG(word)			((word) >> 32)
+#define LS_SHARED_ARENA_FREE_WORD(index, tag)	(LS_CAST(index, ls_u64_t) | (LS_CAST(tag, ls_u64_t) << 32))
+
+
+/* start of the shared object */
+typedef struct
+{
+	ls_u64_t	_magic;  /* set last, once the rest is ready */
+	ls_u64_t	_chunk_size;
+	ls_u64_t	_max_chunk_c;
+	ls_u64_t	_head_size;  /* bytes before the first chunk */
+
+	ls_u64_t	_chunk_c;
+	ls_u64_t	_next_chunk;  /* 1-based index of the next chunk never handed out */
+	ls_u64_t	_last_deleted_chunk;
+}
+ls_shared_arena_header_s;
+
+
+/* the view of one process */
+typedef struct
+{
+	ls_shared_arena_header_s *_header;
+	ls_u8_p		_memory;	/* first chunk */
+	ls_u32_p	_link_a;	/* per chunk: 1-based index of the next chunk on the free stack */
+	ls_u64_t	_chunk_size;
+	ls_u64_t	_map_size;
+}
+ls_shared_arena_s;
+
+
+static ls_shared_arena_s	ls_shared_arena_create			(int 				 fd, 			ls_u64_t 		size, 	ls_u64_t 	chunk_size, 	ls_result_t *status)	LS_LIBFN;
+static ls_shared_arena_s	ls_shared_arena_open			(int 				 fd, 			ls_result_t    *status)													LS_LIBFN;
+static void					ls_shared_arena_close			(ls_shared_arena_s 	*shared_arena)																		LS_LIBFN;
+static ls_result_t			_ls_shared_arena_map			(ls_shared_arena_s 	*shared_arena, 	int 			fd, 	ls_u64_t 	size, 			ls_u64_t 	 chunk_size)	LS_LIBFN;
+
+static ls_u32_t				ls_shared_arena_get_chunk		(ls_shared_arena_s 	*shared_arena, 	ls_result_t    *status)													LS_LIBFN;
+static void					ls_shared_arena_delete_chunk	(ls_shared_arena_s 	*shared_arena, 	ls_u32_t 		chunk_i)												LS_LIBFN;
+
+static ls_void_p			ls_shared_arena_addr			(ls_shared_arena_s 	*shared_arena, 	ls_u32_t 		chunk_i)												LS_LIBFN;
+static ls_u32_t				ls_shared_arena_index			(ls_shared_arena_s 	*shared_arena, 	ls_void_p 		chunk_p)												LS_LIBFN;
+
+
+static LS_INLINE ls_shared_arena_s ls_shared_arena_create(int fd, ls_u64_t size, ls_u64_t chunk_size, ls_result_t *status)
+{
+	ls_shared_arena_s shared_arena;
+	ls_shared_arena_header_s *header;
+	ls_u64_t head_size	= LS_ROUND_UP_TO(sizeof(ls_shared_arena_header_s), chunk_size);
+	ls_u64_t chunk_c	= (size > head_size) ? (size - head_size) / (chunk_size + sizeof(ls_u32_t)) : 0;
+
+	chunk_c = (chunk_c > LS_SHARED_ARENA_MAX_CHUNK_C) ? LS_SHARED_ARENA_MAX_CHUNK_C : chunk_c;
+
+	if (!chunk_c || ftruncate(fd, LS_CAST(size, off_t)) != 0 || _ls_shared_arena_map(&shared_arena, fd, size, chunk_size) != LS_SUCCESS)
+	{
+		*status = LS_FAIL;
+		shared_arena._header = LS_CAST(LS_NULL, ls_shared_arena_header_s *);
+		return shared_arena;
+	}
+
+	header = shared_arena._header;
+
+	header->_chunk_size			= chunk_size;
+	header->_max_chunk_c		= chunk_c;
+	header->_head_size			= head_size;
+	header->_chunk_c			= 0;
+	header->_next_chunk			= 1;
+	header->_last_deleted_chunk	= 0;
+
+	shared_arena._chunk_size	= chunk_size;
+	shared_arena._memory		= LS_CAST(header, ls_u8_p) + head_size;
+	shared_arena._link_a		= LS_CAST(shared_arena._memory + chunk_c * chunk_size, ls_u32_p);
+
+	__atomic_store_n(&header->_magic, LS_SHARED_ARENA_MAGIC, __ATOMIC_RELEASE);
+
+	*status = LS_SUCCESS;
+
+	return shared_arena;
+}
+
+static LS_INLINE ls_shared_arena_s ls_shared_arena_open(int fd, ls_result_t *status)
+{
+	ls_shared_arena_s shared_arena;
+	ls_shared_arena_header_s *header;
+	ls_shared_arena_header_s peek;
+	struct stat info;
+
+	/* the chunk size decides where to map, read it first */
+	if (fstat(fd, &info) != 0 || LS_CAST(info.st_size, ls_u64_t) < sizeof(ls_shared_arena_header_s)
+		|| pread(fd, &peek, sizeof(peek), 0) != LS_CAST(sizeof(peek), ssize_t)
+		|| _ls_shared_arena_map(&shared_arena, fd, LS_CAST(info.st_size, ls_u64_t),
+			(peek._magic == LS_SHARED_ARENA_MAGIC && peek._chunk_size < LS_CAST(info.st_size, ls_u64_t)) ? peek._chunk_size : 0) != LS_SUCCESS)
+	{
+		*status = LS_FAIL;
+		shared_arena._header = LS_CAST(LS_NULL, ls_shared_arena_header_s *);
+		return shared_arena;
+	}
+
+	header = shared_arena._header;
+
+	if (__atomic_load_n(&header->_magic, __ATOMIC_ACQUIRE) != LS_SHARED_ARENA_MAGIC
+		|| header->_head_size + header->_max_chunk_c * (header->_chunk_size + sizeof(ls_u32_t)) > shared_arena._map_size)
+	{
+		ls_shared_arena_close(&shared_arena);
+
+		*status = LS_FAIL;
+		return shared_arena;
+	}
+
+	shared_arena._chunk_size	= header->_chunk_size;
+	shared_arena._memory		= LS_CAST(header, ls_u8_p) + header->_head_size;
+	shared_arena._link_a		= LS_CAST(shared_arena._memory + header->_max_chunk_c * header->_chunk_size, ls_u32_p);
+
+	*status = LS_SUCCESS;
+
+	return shared_arena;
+}
+
+static LS_INLINE void ls_shared_arena_close(ls_shared_arena_s *shared_arena)
+{
+	if (shared_arena->_header)
+	{
+		munmap(shared_arena->_header, shared_arena->_map_size);
+	}
+
+	shared_arena->_header		= LS_CAST(LS_NULL, ls_shared_arena_header_s *);
+	shared_arena->_memory		= LS_CAST(LS_NULL, ls_u8_p);
+	shared_arena->_link_a		= LS_CAST(LS_NULL, ls_u32_p);
+	shared_arena->_chunk_size	= 0;
+	shared_arena->_map_size		= 0;
+}
+
+/* maps [size] bytes of [fd] at an address aligned to [chunk_size], mmap alone only aligns to the page size */
+static LS_INLINE ls_result_t _ls_shared_arena_map(ls_shared_arena_s *shared_arena, int fd, ls_u64_t size, ls_u64_t chunk_size)
+{
+	ls_u64_t page_size	= LS_CAST(sysconf(_SC_PAGESIZE), ls_u64_t);
+	ls_u64_t slack		= (chunk_size > page_size) ? chunk_size - page_size : 0;
+	ls_u8_p reserve;
+	ls_u8_p start;
+	ls_void_p memory;
+
+	/* reserve the slack on top, then map over the aligned part and give the rest back */
+	reserve = LS_CAST(mmap(LS_NULL, size + slack, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0), ls_u8_p);
+
+	if (LS_CAST(reserve, ls_void_p) == MAP_FAILED)
+	{
+		return LS_FAIL;
+	}
+
+	start	= slack ? LS_CAST(LS_ROUND_UP_TO(LS_CAST(reserve, ls_u64_t), chunk_size), ls_u8_p) : reserve;
+	memory	= mmap(start, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+
+	if (memory == MAP_FAILED)
+	{
+		munmap(reserve, size + slack);
+		return LS_FAIL;
+	}
+
+	if (start > reserve)
+	{
+		munmap(reserve, LS_CAST(start - reserve, ls_u64_t));
+	}
+
+	if (reserve + size + slack > start + LS_ROUND_UP_TO(size, page_size))
+	{
+		munmap(start + LS_ROUND_UP_TO(size, page_size), LS_CAST(reserve + size + slack - (start + LS_ROUND_UP_TO(size, page_size)), ls_u64_t));
+	}
+
+	shared_arena->_header	= LS_CAST(memory, ls_shared_arena_header_s *);
+	shared_arena->_map_size	= size;
+
+	return LS_SUCCESS;
+}
+
+
+static LS_INLINE ls_u32_t ls_shared_arena_get_chunk(ls_shared_arena_s *shared_arena, ls_result_t *status)
+{
+	ls_shared_arena_header_s *header = shared_arena->_header;
+	ls_u64_t chunk_c;
+	ls_u64_t chunk_i;
+	ls_u64_t head;
+	ls_u64_t next;
+
+	/* reserve a chunk first, so the loop below always finds one */
+	chunk_c = __atomic_load_n(&header->_chunk_c, __ATOMIC_RELAXED);
+
+	do
+	{
+		if (chunk_c == header->_max_chunk_c)
+		{
+			*status = LS_SHARED_ARENA_MEM_FULL;
+			return LS_SHARED_ARENA_NULL_INDEX;
+		}
+	}
+	while (!__atomic_compare_exchange_n(&header->_chunk_c, &chunk_c, chunk_c + 1, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+
+	*status = LS_SUCCESS;
+
+	for (;;)
+	{
+		head = __atomic_load_n(&header->_last_deleted_chunk, __ATOMIC_ACQUIRE);
+
+		if (LS_SHARED_ARENA_FREE_INDEX(head))
+		{
+			/* may read a chunk another thread already popped, the tag then fails the exchange */
+			next = __atomic_load_n(&shared_arena->_link_a[LS_SHARED_ARENA_FREE_INDEX(head) - 1], __ATOMIC_RELAXED);
+
+			if (__atomic_compare_exchange_n(&header->_last_deleted_chunk, &head, LS_SHARED_ARENA_FREE_WORD(next, LS_SHARED_ARENA_FREE_TAG(head) + 1),
+				1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			{
+				return LS_CAST(LS_SHARED_ARENA_FREE_INDEX(head) - 1, ls_u32_t);
+			}
+
+			continue;
+		}
+
+		chunk_i = __atomic_load_n(&header->_next_chunk, __ATOMIC_RELAXED);
+
+		if (chunk_i <= header->_max_chunk_c)
+		{
+			if (__atomic_compare_exchange_n(&header->_next_chunk, &chunk_i, chunk_i + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			{
+				return LS_CAST(chunk_i - 1, ls_u32_t);
+			}
+
+			continue;
+		}
+
+		/* every chunk was handed out once: a delete that released our reservation is still pushing its chunk */
+	}
+}
+
+static LS_INLINE void ls_shared_arena_delete_chunk(ls_shared_arena_s *shared_arena, ls_u32_t chunk_i)
+{
+	ls_shared_arena_header_s *header = shared_arena->_header;
+	ls_u64_t head = __atomic_load_n(&header->_last_deleted_chunk, __ATOMIC_RELAXED);
+
+	do
+	{
+		__atomic_store_n(&shared_arena->_link_a[chunk_i], LS_CAST(LS_SHARED_ARENA_FREE_INDEX(head), ls_u32_t), __ATOMIC_RELAXED);
+	}
+	while (!__atomic_compare_exchange_n(&header->_last_deleted_chunk, &head, LS_SHARED_ARENA_FREE_WORD(chunk_i + 1, LS_SHARED_ARENA_FREE_TAG(head) + 1),
+		1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+	/* only after the push, so a reserved chunk is always reachable */
+	__atomic_fetch_sub(&header->_chunk_c, 1, __ATOMIC_RELEASE);
+}
+
+
+static LS_INLINE ls_void_p ls_shared_arena_addr(ls_shared_arena_s *shared_arena, ls_u32_t chunk_i)
+{
+	return LS_CAST(shared_arena->_memory + LS_CAST(chunk_i, ls_u64_t) * shared_arena->_chunk_size, ls_void_p);
+}
+
+static LS_INLINE ls_u32_t ls_shared_arena_index(ls_shared_arena_s *shared_arena, ls_void_p chunk_p)
+{
+	return LS_CAST((LS_CAST(chunk_p, ls_u8_p) - shared_arena->_memory) / shared_arena->_chunk_size, ls_u32_t);
+}
+
+
+#endif  /* #ifndef LS_SHARED_ARENA_H */
+
+
+/*
+ * Copyright (C) 2025  Logan Seeley
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
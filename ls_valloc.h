@@ -1,5 +1,5 @@
 /*
- * ls_valloc.h - v1.1.1 - virtual memory allocator - Logan Seeley 2025
+ * ls_valloc.h - v1.6.1 - virtual memory allocator - Logan Seeley 2025
  *
  * Documentation
  *
@@ -20,15 +20,109 @@
  *          Decommmits all committed pages of [ptr].
  * 
  *      void ls_valloc_pfree_range(ls_void_p ptr, ls_u64_t offset, ls_u64_t range) - pfree_range
- *          Decommits pages past an offset and to a range.
+ *          Decommits every whole page inside [offset, offset + range).
  * 
  *      void ls_valloc_pcommit_range(ls_void_p ptr, ls_u64_t offset, ls_u64_t range) - pcommit_range_win32
  *          Before writing to memory, you must specify where
  *          you plan on writing to[1].
  *
+ *      void ls_valloc_zero_range(ls_void_p ptr, ls_u64_t offset, ls_u64_t range, ls_bool_t reuse) - zero_range
+ *          Sets [offset, offset + range) to zero, choosing the cheapest way for the size:
+ *              below LS_VALLOC_ZERO_STREAM_THRES           -> memset
+ *              [reuse] is LS_TRUE or below LS_VALLOC_ZERO_DISCARD_THRES
+ *                                                          -> non-temporal stores, bypassing the cache
+ *              otherwise                                   -> whole pages are discarded, so they are
+ *                                                             zero-filled by the system on next touch
+ *          [reuse] tells whether the range will be written again soon.
+ *          Discarded pages are decommitted, call ls_valloc_pcommit_range before reusing them.
+ *
+ *      ls_result_t ls_valloc_prefault(ls_void_p ptr, ls_u64_t offset, ls_u64_t range, ls_u32_t thread_c, const ls_u32_t *node_map) - prefault
+ *          Commits and populates every page overlapping [offset, offset + range), split
+ *          in [thread_c] page aligned slices that are populated in parallel.
+ *          [node_map] may be LS_NULL, otherwise slice [i] is placed on NUMA node [node_map[i]].
+ *          Populating uses MADV_POPULATE_WRITE where available and touches every page otherwise.
+ *          At most LS_VALLOC_PREFAULT_MAX_THREADS threads are used.
+ *          Returns LS_FAIL if any slice could not be populated.
+ *
+ *      ls_result_t ls_valloc_residency(ls_void_p ptr, ls_u64_t offset, ls_u64_t range, ls_valloc_residency_s *stats, ls_u8_p page_map) - residency
+ *          Reports how many bytes of the pages overlapping [offset, offset + range)
+ *          are resident, swapped out and backed by huge pages[2].
+ *          [stats] is out.
+ *          [page_map] is out and may be LS_NULL, otherwise it receives one byte
+ *          of LS_VALLOC_PAGE_* flags per page, starting at the page containing [offset].
+ *          Returns LS_FAIL if the page state could not be queried.
+ *
+ *      ls_result_t ls_valloc_phint_range(ls_void_p ptr, ls_u64_t offset, ls_u64_t range, ls_u32_t hint) - phint_range
+ *          Tells the system how the pages overlapping [offset, offset + range) will be used:
+ *              LS_VALLOC_HINT_COLD         -> reclaim these first (MADV_COLD), contents are kept
+ *              LS_VALLOC_HINT_PAGEOUT      -> reclaim these now, to swap or zswap (MADV_PAGEOUT)
+ *              LS_VALLOC_HINT_MERGEABLE    -> let KSM deduplicate identical pages (MADV_MERGEABLE)
+ *              LS_VALLOC_HINT_UNMERGEABLE  -> undo LS_VALLOC_HINT_MERGEABLE
+ *          Returns LS_FAIL if the hint is not supported[4].
+ *
+ *      ls_result_t ls_valloc_access_sample(ls_void_p ptr, ls_u64_t offset, ls_u64_t range) - access_sample
+ *          Starts tracking accesses to the pages overlapping [offset, offset + range)[5].
+ *          Returns LS_FAIL if accesses cannot be tracked.
+ *
+ *      ls_u64_t ls_valloc_access_apply(ls_void_p ptr, ls_u64_t offset, ls_u64_t range, ls_u32_t hint) - access_apply
+ *          Applies [hint] to every resident page overlapping [offset, offset + range)
+ *          that was not accessed since the last [ls_valloc_access_sample] of the range.
+ *          Returns the amount of bytes hinted, 0 if accesses cannot be tracked[5].
+ *
+ *      ls_result_t ls_valloc_reclaim_register(ls_void_p ptr, ls_u64_t offset, ls_u64_t range, ls_u32_t priority, ls_valloc_reclaim_fn fn, ls_void_p user, ls_u32_p id) - reclaim_register
+ *          Marks [offset, offset + range) of [ptr] as reclaimable cache. Under memory
+ *          pressure, registered ranges are decommitted lowest [priority] first.
+ *          [fn] may be LS_NULL, otherwise it is called before the range is decommitted
+ *          and may return LS_FALSE to keep it[3].
+ *          [id] is out, pass it to [ls_valloc_reclaim_unregister].
+ *          Returns LS_FAIL if LS_VALLOC_RECLAIM_MAX ranges are already registered.
+ *
+ *      void ls_valloc_reclaim_unregister(ls_u32_t id) - reclaim_unregister
+ *          Out of range ids are ignored.
+ *
+ *      ls_u64_t ls_valloc_reclaim_run(ls_u64_t target) - reclaim_run
+ *          Decommits registered ranges, lowest priority first, until at least
+ *          [target] resident bytes were released or every range was visited.
+ *          Returns the amount of resident bytes released.
+ *
+ *      ls_result_t ls_valloc_reclaim_start(const char *source) - reclaim_start
+ *          Starts a monitor thread that calls ls_valloc_reclaim_run(LS_VALLOC_RECLAIM_STEP)
+ *          every time memory pressure is reported by [source]:
+ *              LS_NULL             -> /proc/pressure/memory
+ *              "*memory.events"    -> a cgroup v2 memory.events file, any new high/max/oom event
+ *              anything else       -> a PSI file (e.g. a cgroup's memory.pressure)
+ *          On windows [source] is ignored and the low memory resource notification is used.
+ *          Pressure keeps being reported while it lasts, so ranges keep being released
+ *          one step at a time until it drops.
+ *
+ *      void ls_valloc_reclaim_trigger(void) - reclaim_trigger
+ *          Makes the monitor thread run one reclaim step as if pressure was reported.
+ *
+ *      void ls_valloc_reclaim_stop(void) - reclaim_stop
+ *          The monitor also exits on its own if [source] goes away (e.g. its cgroup
+ *          is removed), [ls_valloc_reclaim_start] may then be called again.
+ *
  *      [^] [ptr] must have been returned by [ls_vmalloc()] for each function.
  *      
  *      [1] Note that this function only does anything on windows, use anyways (compatability).
+ *
+ *      [2] On linux, resident pages come from mincore and swapped pages from /proc/self/pagemap.
+ *          Huge pages are exact when page frame numbers are visible (CAP_SYS_ADMIN), otherwise
+ *          they are taken from the AnonHugePages of every mapping overlapping the range,
+ *          capped to the resident bytes, and are not marked in [page_map].
+ *          On windows, swapped bytes are always reported as 0.
+ *
+ *      [3] The registry is locked while [fn] runs; [fn] must not register or unregister ranges.
+ *          The registry is per translation unit, like every function in this file.
+ *
+ *      [4] On windows, only LS_VALLOC_HINT_PAGEOUT is supported (pages are trimmed from the working set).
+ *
+ *      [5] Accesses are taken from /sys/kernel/mm/page_idle when page frame numbers are visible
+ *          (CAP_SYS_ADMIN), otherwise sampling fails and applying hints nothing.
+ *          Define LS_VALLOC_ACCESS_WRITE_ONLY to fall back to tracking writes only, through the
+ *          soft-dirty bits of /proc/self/pagemap: pages only read count as not accessed, and
+ *          sampling clears the soft-dirty bits of the whole process, so nothing else in the
+ *          process may rely on them. Not supported on windows.
  */
 
 
@@ -41,11 +135,129 @@
 
 #include <stdio.h>
 
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
 #ifdef _WIN32
     #include <windows.h>
+    #include <psapi.h>
 #else
     #include <sys/mman.h>
     #include <unistd.h>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <pthread.h>
+
+    #ifdef __linux__
+        #include <sys/inotify.h>
+        #include <sys/syscall.h>
+    #endif
+#endif
+
+
+#define LS_VALLOC_PAGE_RESIDENT     0x1
+#define LS_VALLOC_PAGE_SWAPPED      0x2
+#define LS_VALLOC_PAGE_HUGE         0x4
+
+#define LS_VALLOC_RESIDENCY_BATCH   512  /* pages queried per system call */
+
+#define LS_VALLOC_HINT_COLD         0
+#define LS_VALLOC_HINT_PAGEOUT      1
+#define LS_VALLOC_HINT_MERGEABLE    2
+#define LS_VALLOC_HINT_UNMERGEABLE  3
+
+#ifndef LS_VALLOC_ZERO_STREAM_THRES
+    #define LS_VALLOC_ZERO_STREAM_THRES     0x40000llu   /* 256 KiB, roughly what stays in cache */
+#endif
+
+#ifndef LS_VALLOC_ZERO_DISCARD_THRES
+    #define LS_VALLOC_ZERO_DISCARD_THRES    0x100000llu  /* 1 MiB, below that faulting back costs more */
+#endif
+
+#ifndef LS_VALLOC_PREFAULT_MAX_THREADS
+    #define LS_VALLOC_PREFAULT_MAX_THREADS  256
+#endif
+
+#ifndef LS_VALLOC_RECLAIM_MAX
+    #define LS_VALLOC_RECLAIM_MAX   64  /* reclaimable ranges registered at once */
+#endif
+
+#ifndef LS_VALLOC_RECLAIM_STEP
+    #define LS_VALLOC_RECLAIM_STEP  0x4000000llu  /* 64 MiB, released per pressure report */
+#endif
+
+#ifndef LS_VALLOC_PSI_TRIGGER
+    /* 150ms of stall within a 2s window, unprivileged triggers need a window multiple of 2s */
+    #define LS_VALLOC_PSI_TRIGGER   "some 150000 2000000"
+#endif
+
+
+typedef ls_bool_t (*ls_valloc_reclaim_fn)(ls_void_p ptr, ls_u64_t offset, ls_u64_t range, ls_void_p user);
+
+
+typedef struct
+{
+    ls_u64_t    page_c;
+    ls_u64_t    resident_bytes;
+    ls_u64_t    swapped_bytes;
+    ls_u64_t    huge_bytes;
+}
+ls_valloc_residency_s;
+
+
+typedef struct
+{
+    ls_u8_p     start;
+    ls_u64_t    size;
+    ls_u64_t    page_size;
+    ls_s64_t    node;  /* -1 if unbound */
+    ls_result_t result;
+}
+_ls_valloc_prefault_slice_s;
+
+
+typedef struct
+{
+    ls_void_p               ptr;
+    ls_u64_t                offset;
+    ls_u64_t                range;
+    ls_u32_t                priority;
+    ls_valloc_reclaim_fn    fn;
+    ls_void_p               user;
+    ls_bool_t               used;
+}
+_ls_valloc_reclaim_entry_s;
+
+
+/* zero initialized, the lock is kept apart for its initializer */
+static struct
+{
+    _ls_valloc_reclaim_entry_s  entry_a[LS_VALLOC_RECLAIM_MAX];
+
+    ls_bool_t                   started;    /* a monitor thread exists, only touched by start and stop */
+
+    #ifdef _WIN32
+        LONG volatile           running;    /* the monitor serves pressure, cleared when it exits */
+        HANDLE                  thread;
+        HANDLE                  wake_event;
+        HANDLE                  stop_event;
+    #else
+        ls_bool_t               running;
+        pthread_t               thread;
+        int                     wake_fd[2];
+        int                     source_fd;
+        ls_bool_t               source_events;
+        ls_u64_t                event_c;
+        char                    source[256];
+    #endif
+}
+_ls_valloc_reclaim_meta;
+
+#ifdef _WIN32
+    static SRWLOCK          _ls_valloc_reclaim_mutex = SRWLOCK_INIT;
+#else
+    static pthread_mutex_t  _ls_valloc_reclaim_mutex = PTHREAD_MUTEX_INITIALIZER;
 #endif
 
 
@@ -54,6 +266,55 @@ static void        ls_valloc_vfree      (ls_void_p ptr)
 static void        ls_valloc_pfree      (ls_void_p ptr)                                     LS_LIBFN;
 static void        ls_valloc_pfree_range(ls_void_p ptr, ls_u64_t offset, ls_u64_t range)    LS_LIBFN;
 
+static void        ls_valloc_zero_range (ls_void_p ptr, ls_u64_t offset, ls_u64_t range, ls_bool_t reuse) LS_LIBFN;
+static void        _ls_valloc_zero_stream(ls_u8_p   dst, ls_u64_t size)                                   LS_LIBFN;
+
+static ls_result_t ls_valloc_prefault   (ls_void_p ptr, ls_u64_t offset, ls_u64_t range, ls_u32_t thread_c, const ls_u32_t *node_map) LS_LIBFN;
+static void        _ls_valloc_prefault_slice(_ls_valloc_prefault_slice_s *slice)                                 LS_LIBFN;
+
+#ifdef _WIN32
+    static DWORD WINAPI _ls_valloc_prefault_thread(LPVOID arg)                                                  LS_LIBFN;
+#else
+    static void       *_ls_valloc_prefault_thread(void *arg)                                                    LS_LIBFN;
+#endif
+
+static ls_result_t ls_valloc_residency  (ls_void_p ptr, ls_u64_t offset, ls_u64_t range, ls_valloc_residency_s *stats, ls_u8_p page_map) LS_LIBFN;
+
+static ls_result_t ls_valloc_phint_range   (ls_void_p ptr, ls_u64_t offset, ls_u64_t range, ls_u32_t hint)  LS_LIBFN;
+static ls_result_t ls_valloc_access_sample (ls_void_p ptr, ls_u64_t offset, ls_u64_t range)                 LS_LIBFN;
+static ls_u64_t    ls_valloc_access_apply  (ls_void_p ptr, ls_u64_t offset, ls_u64_t range, ls_u32_t hint)  LS_LIBFN;
+
+static ls_result_t _ls_valloc_hint         (ls_void_p addr, ls_u64_t size, ls_u32_t hint)                   LS_LIBFN;
+
+#ifndef _WIN32
+    static ls_result_t _ls_valloc_access_scan (ls_u64_t start, ls_u64_t end, ls_bool_t mark, ls_u32_t hint, ls_u64_p hinted) LS_LIBFN;
+    static void        _ls_valloc_access_flush(ls_u64_t run_start, ls_u64_t run_end, ls_u32_t hint, ls_u64_p hinted)       LS_LIBFN;
+#endif
+
+static ls_result_t ls_valloc_reclaim_register  (ls_void_p ptr, ls_u64_t offset, ls_u64_t range, ls_u32_t priority, ls_valloc_reclaim_fn fn, ls_void_p user, ls_u32_p id) LS_LIBFN;
+static void        ls_valloc_reclaim_unregister(ls_u32_t id)               LS_LIBFN;
+static ls_u64_t    ls_valloc_reclaim_run       (ls_u64_t target)           LS_LIBFN;
+static ls_result_t ls_valloc_reclaim_start     (const char *source)        LS_LIBFN;
+static void        ls_valloc_reclaim_trigger   (void)                      LS_LIBFN;
+static void        ls_valloc_reclaim_stop      (void)                      LS_LIBFN;
+
+static void        _ls_valloc_reclaim_lock     (void)                      LS_LIBFN;
+static void        _ls_valloc_reclaim_unlock   (void)                      LS_LIBFN;
+static ls_bool_t   _ls_valloc_reclaim_running  (void)                      LS_LIBFN;
+static void        _ls_valloc_reclaim_set_running(ls_bool_t running)       LS_LIBFN;
+static void        _ls_valloc_reclaim_join     (void)                      LS_LIBFN;
+static ls_bool_t   _ls_valloc_reclaim_wait     (void)                      LS_LIBFN;
+
+#ifdef __linux__
+    static ls_u64_t    _ls_valloc_reclaim_event_c  (void)                      LS_LIBFN;
+#endif
+
+#ifdef _WIN32
+    static DWORD WINAPI _ls_valloc_reclaim_monitor(LPVOID arg)             LS_LIBFN;
+#else
+    static void       *_ls_valloc_reclaim_monitor(void *arg)               LS_LIBFN;
+#endif
+
 #ifdef _WIN32
     static void _ls_valloc_pcommit_range_win32(ls_void_p ptr, ls_u64_t offset, ls_u64_t range) LS_LIBFN;
 
@@ -65,6 +326,10 @@ static void        ls_valloc_pfree_range(ls_void_p ptr, ls_u64_t offset, ls_u64_
 static ls_u64_t _ls_valloc_page_size(void);
 static ls_u64_t _ls_valloc_memtotal(void);
 
+#ifndef _WIN32
+    static ls_u64_t _ls_valloc_smaps_huge_bytes(ls_u64_t start, ls_u64_t end) LS_LIBFN;
+#endif
+
 
 static LS_INLINE ls_void_p ls_valloc_vmalloc(ls_u64_p size)
 {
@@ -106,85 +371,1234 @@ static LS_INLINE void ls_valloc_pfree(ls_void_p ptr)
 static LS_INLINE void ls_valloc_pfree_range(ls_void_p ptr, ls_u64_t offset, ls_u64_t range)
 {
     ls_u64_t page_size = _ls_valloc_page_size();
+    ls_u64_t size      = LS_ROUND_UP_TO(_ls_valloc_memtotal(), page_size);
+    ls_u64_t end       = LS_ROUND_DOWN_TO(offset + range, page_size);
 
-    offset = LS_ROUND_DOWN_TO(offset, page_size) + page_size;
-    range  = LS_ROUND_DOWN_TO(range, page_size);
-    
-    if (range != 0 || offset >= _ls_valloc_memtotal())
+    offset = LS_ROUND_UP_TO(offset, page_size);  /* only whole pages inside the range */
+
+    if (end > size)
+    {
+        end = size;
+    }
+
+    if (offset >= end)
     {
         return;  /* nothing to do */
     }
     
-    if (offset + range > _ls_valloc_memtotal())
+    #ifdef _WIN32
+        VirtualFree(LS_CAST(LS_CAST(ptr, ls_u64_t) + offset, ls_void_p), end - offset, MEM_DECOMMIT);
+    #else
+        madvise(LS_CAST(LS_CAST(ptr, ls_u64_t) + offset, ls_void_p), end - offset, MADV_DONTNEED);
+    #endif
+}
+
+
+static LS_INLINE void ls_valloc_zero_range(ls_void_p ptr, ls_u64_t offset, ls_u64_t range, ls_bool_t reuse)
+{
+    ls_u8_p  base = LS_CAST(ptr, ls_u8_p);
+    ls_u64_t page_size;
+    ls_u64_t page_start;
+    ls_u64_t page_end;
+
+    if (range < LS_VALLOC_ZERO_STREAM_THRES)
     {
-        range = _ls_valloc_memtotal() - offset;
+        LS_MEMSET(base + offset, 0, range);
+        return;
     }
-    
+
+    if (reuse || range < LS_VALLOC_ZERO_DISCARD_THRES)
+    {
+        _ls_valloc_zero_stream(base + offset, range);
+        return;
+    }
+
+    page_size  = _ls_valloc_page_size();
+    page_start = LS_ROUND_UP_TO(offset, page_size);
+    page_end   = LS_ROUND_DOWN_TO(offset + range, page_size);
+
+    /* partial pages at either end cannot be discarded */
+    LS_MEMSET(base + offset,   0, page_start - offset);
+    LS_MEMSET(base + page_end, 0, offset + range - page_end);
+
+    /* anonymous private pages read back as zero once discarded */
+    ls_valloc_pfree_range(ptr, page_start, page_end - page_start);
+}
+
+
+static LS_INLINE void _ls_valloc_zero_stream(ls_u8_p dst, ls_u64_t size)
+{
+    #if defined(__SSE2__)
+        __m128i  zero = _mm_setzero_si128();
+        ls_u64_t head = LS_ROUND_UP_TO(LS_CAST(dst, ls_u64_t), 64) - LS_CAST(dst, ls_u64_t);
+        ls_u64_t body;
+        ls_u64_t i;
+
+        head = (head > size) ? size : head;
+        body = LS_ROUND_DOWN_TO(size - head, 64);
+
+        LS_MEMSET(dst, 0, head);
+
+        for (i = head; i < head + body; i += 64)
+        {
+            _mm_stream_si128(LS_CAST(dst + i,      __m128i *), zero);
+            _mm_stream_si128(LS_CAST(dst + i + 16, __m128i *), zero);
+            _mm_stream_si128(LS_CAST(dst + i + 32, __m128i *), zero);
+            _mm_stream_si128(LS_CAST(dst + i + 48, __m128i *), zero);
+        }
+
+        _mm_sfence();  /* streaming stores are weakly ordered */
+
+        LS_MEMSET(dst + head + body, 0, size - head - body);
+    #else
+        LS_MEMSET(dst, 0, size);
+    #endif
+}
+
+
+static LS_INLINE ls_result_t ls_valloc_prefault(ls_void_p ptr, ls_u64_t offset, ls_u64_t range, ls_u32_t thread_c, const ls_u32_t *node_map)
+{
+    _ls_valloc_prefault_slice_s slice_a[LS_VALLOC_PREFAULT_MAX_THREADS];
+
     #ifdef _WIN32
-        VirtualFree(LS_CAST(LS_CAST(ptr, ls_u64_t) + offset, ls_void_p), range, MEM_DECOMMIT);
+        HANDLE    thread_a[LS_VALLOC_PREFAULT_MAX_THREADS];
     #else
-        madvise(LS_CAST(LS_CAST(ptr, ls_u64_t) + offset, ls_void_p), range, MADV_DONTNEED);
+        pthread_t thread_a[LS_VALLOC_PREFAULT_MAX_THREADS];
     #endif
+
+    ls_bool_t   spawned_a[LS_VALLOC_PREFAULT_MAX_THREADS];
+    ls_u64_t    page_size = _ls_valloc_page_size();
+    ls_u64_t    end       = LS_ROUND_UP_TO(offset + range, page_size);
+    ls_u64_t    size      = LS_ROUND_UP_TO(_ls_valloc_memtotal(), page_size);
+    ls_u64_t    slice_z;
+    ls_result_t result    = LS_SUCCESS;
+    ls_u32_t    i;
+
+    offset = LS_ROUND_DOWN_TO(offset, page_size);
+
+    if (end > size)
+    {
+        end = size;
+    }
+
+    if (offset >= end)
+    {
+        return LS_SUCCESS;  /* nothing to do */
+    }
+
+    thread_c = (thread_c == 0) ? 1 : thread_c;
+    thread_c = (thread_c > LS_VALLOC_PREFAULT_MAX_THREADS) ? LS_VALLOC_PREFAULT_MAX_THREADS : thread_c;
+
+    slice_z = LS_ROUND_UP_TO((end - offset + thread_c - 1) / thread_c, page_size);
+
+    for (i = 0; i < thread_c; i++)
+    {
+        ls_u64_t slice_start = offset + i * slice_z;
+        ls_u64_t slice_end   = slice_start + slice_z;
+
+        slice_start = (slice_start > end) ? end : slice_start;
+        slice_end   = (slice_end   > end) ? end : slice_end;
+
+        slice_a[i].start     = LS_CAST(ptr, ls_u8_p) + slice_start;
+        slice_a[i].size      = slice_end - slice_start;
+        slice_a[i].page_size = page_size;
+        slice_a[i].node      = (node_map != LS_NULL) ? LS_CAST(node_map[i], ls_s64_t) : -1;
+        slice_a[i].result    = LS_SUCCESS;
+
+        spawned_a[i] = LS_FALSE;
+    }
+
+    /* the calling thread populates slice 0 */
+    for (i = 1; i < thread_c; i++)
+    {
+        if (slice_a[i].size == 0)
+        {
+            continue;
+        }
+
+        #ifdef _WIN32
+            thread_a[i]  = CreateThread(LS_NULL, 0, _ls_valloc_prefault_thread, &slice_a[i], 0, LS_NULL);
+            spawned_a[i] = thread_a[i] != LS_NULL;
+        #else
+            spawned_a[i] = pthread_create(&thread_a[i], LS_CAST(LS_NULL, pthread_attr_t *), _ls_valloc_prefault_thread, &slice_a[i]) == 0;
+        #endif
+    }
+
+    _ls_valloc_prefault_slice(&slice_a[0]);
+
+    for (i = 1; i < thread_c; i++)
+    {
+        if (spawned_a[i])
+        {
+            #ifdef _WIN32
+                WaitForSingleObject(thread_a[i], INFINITE);
+                CloseHandle(thread_a[i]);
+            #else
+                pthread_join(thread_a[i], LS_CAST(LS_NULL, void **));
+            #endif
+        }
+        else if (slice_a[i].size != 0)
+        {
+            _ls_valloc_prefault_slice(&slice_a[i]);  /* could not spawn, do it here */
+        }
+    }
+
+    for (i = 0; i < thread_c; i++)
+    {
+        result = (slice_a[i].result != LS_SUCCESS) ? LS_FAIL : result;
+    }
+
+    return result;
 }
 
 
+static LS_INLINE void _ls_valloc_prefault_slice(_ls_valloc_prefault_slice_s *slice)
+{
+    volatile ls_u8_t *page;
+    ls_u64_t          i;
+
+    if (slice->size == 0)
+    {
+        return;
+    }
+
+    #ifdef _WIN32
+        if (slice->node >= 0)
+        {
+            if (VirtualAllocExNuma(GetCurrentProcess(), slice->start, slice->size, MEM_COMMIT, PAGE_READWRITE, LS_CAST(slice->node, DWORD)) == LS_NULL)
+            {
+                slice->result = LS_FAIL;
+                return;
+            }
+        }
+        else if (VirtualAlloc(slice->start, slice->size, MEM_COMMIT, PAGE_READWRITE) == LS_NULL)
+        {
+            slice->result = LS_FAIL;
+            return;
+        }
+    #else
+        #if defined(__linux__) && defined(SYS_mbind)
+            if (slice->node >= 0)
+            {
+                unsigned long nodemask[16] = { 0 };  /* up to 1024 nodes */
+
+                if (slice->node >= LS_CAST(sizeof(nodemask) * 8, ls_s64_t))
+                {
+                    slice->result = LS_FAIL;
+                    return;
+                }
+
+                nodemask[slice->node / (sizeof(unsigned long) * 8)] |= 1ul << (slice->node % (sizeof(unsigned long) * 8));
+
+                /* 1: MPOL_PREFERRED, falls back to other nodes instead of failing */
+                if (syscall(SYS_mbind, slice->start, slice->size, 1, nodemask, sizeof(nodemask) * 8, 0) != 0)
+                {
+                    slice->result = LS_FAIL;
+                    return;
+                }
+            }
+        #endif
+
+        #if defined(MADV_POPULATE_WRITE)
+            if (madvise(slice->start, slice->size, MADV_POPULATE_WRITE) == 0)
+            {
+                return;
+            }
+        #endif
+    #endif
+
+    /* read and write back, contents are preserved */
+    for (i = 0; i < slice->size; i += slice->page_size)
+    {
+        page    = slice->start + i;
+        page[0] = page[0];
+    }
+}
+
 #ifdef _WIN32
+static DWORD WINAPI _ls_valloc_prefault_thread(LPVOID arg)
+#else
+static void *_ls_valloc_prefault_thread(void *arg)
+#endif
+{
+    _ls_valloc_prefault_slice(LS_CAST(arg, _ls_valloc_prefault_slice_s *));
 
-static LS_INLINE void _ls_valloc_pcommit_range_win32(ls_void_p ptr, ls_u64_t offset, ls_u64_t range)
+    #ifdef _WIN32
+        return 0;
+    #else
+        return LS_NULL;
+    #endif
+}
+
+
+static LS_INLINE ls_result_t ls_valloc_residency(ls_void_p ptr, ls_u64_t offset, ls_u64_t range, ls_valloc_residency_s *stats, ls_u8_p page_map)
 {
     ls_u64_t page_size = _ls_valloc_page_size();
-    
+    ls_u64_t end       = LS_ROUND_UP_TO(offset + range, page_size);
+    ls_u64_t size      = LS_ROUND_UP_TO(_ls_valloc_memtotal(), page_size);
+    ls_u64_t page_i;
+    ls_u64_t batch_c;
+    ls_u64_t i;
+
+    LS_MEMSET(stats, 0, sizeof(ls_valloc_residency_s));
+
     offset = LS_ROUND_DOWN_TO(offset, page_size);
-    range  = LS_ROUND_UP_TO(range, page_size);
-    
-    if (range == 0 || offset >= _ls_valloc_memtotal())
+
+    if (end > size)
     {
-        return;  /* nothing to do */
+        end = size;
     }
-    
-    if (offset + range > _ls_valloc_memtotal())
+
+    if (offset >= end)
     {
-        range = _ls_valloc_memtotal() - offset;
+        return LS_SUCCESS;  /* nothing to do */
     }
-    
-    VirtualAlloc(LS_CAST(LS_CAST(ptr, ls_u64_t) + offset, ls_void_p), range, MEM_COMMIT, PAGE_READWRITE);
+
+    stats->page_c = (end - offset) / page_size;
+
+    #ifdef _WIN32
+        PSAPI_WORKING_SET_EX_INFORMATION ws_info[LS_VALLOC_RESIDENCY_BATCH];
+
+        for (page_i = 0; page_i < stats->page_c; page_i += batch_c)
+        {
+            batch_c = stats->page_c - page_i;
+            batch_c = (batch_c > LS_VALLOC_RESIDENCY_BATCH) ? LS_VALLOC_RESIDENCY_BATCH : batch_c;
+
+            for (i = 0; i < batch_c; i++)
+            {
+                ws_info[i].VirtualAddress = LS_CAST(LS_CAST(ptr, ls_u64_t) + offset + (page_i + i) * page_size, ls_void_p);
+            }
+
+            if (!QueryWorkingSetEx(GetCurrentProcess(), ws_info, LS_CAST(batch_c * sizeof(ws_info[0]), DWORD)))
+            {
+                return LS_FAIL;
+            }
+
+            for (i = 0; i < batch_c; i++)
+            {
+                ls_u8_t flags = 0;
+
+                if (ws_info[i].VirtualAttributes.Valid)
+                {
+                    flags |= LS_VALLOC_PAGE_RESIDENT;
+                    stats->resident_bytes += page_size;
+
+                    if (ws_info[i].VirtualAttributes.LargePage)
+                    {
+                        flags |= LS_VALLOC_PAGE_HUGE;
+                        stats->huge_bytes += page_size;
+                    }
+                }
+
+                if (page_map != LS_NULL)
+                {
+                    page_map[page_i + i] = flags;
+                }
+            }
+        }
+    #else
+        unsigned char core_v[LS_VALLOC_RESIDENCY_BATCH];
+        ls_u64_t      pagemap_v[LS_VALLOC_RESIDENCY_BATCH];
+        ls_u64_t      kpage_flags;
+        ls_u64_t      pfn;
+        ls_u64_t      addr;
+        ls_bool_t     pfn_visible = LS_FALSE;
+        int           pagemap_fd;
+        int           kpageflags_fd;
+
+        pagemap_fd    = open("/proc/self/pagemap", O_RDONLY);
+        kpageflags_fd = open("/proc/kpageflags",   O_RDONLY);
+
+        for (page_i = 0; page_i < stats->page_c; page_i += batch_c)
+        {
+            batch_c = stats->page_c - page_i;
+            batch_c = (batch_c > LS_VALLOC_RESIDENCY_BATCH) ? LS_VALLOC_RESIDENCY_BATCH : batch_c;
+
+            addr = LS_CAST(ptr, ls_u64_t) + offset + page_i * page_size;
+
+            if (mincore(LS_CAST(addr, ls_void_p), batch_c * page_size, core_v) != 0)
+            {
+                if (pagemap_fd >= 0)    close(pagemap_fd);
+                if (kpageflags_fd >= 0) close(kpageflags_fd);
+
+                return LS_FAIL;
+            }
+
+            if (pagemap_fd < 0 || pread(pagemap_fd, pagemap_v, batch_c * sizeof(ls_u64_t),
+                    LS_CAST(addr / page_size * sizeof(ls_u64_t), off_t)) != LS_CAST(batch_c * sizeof(ls_u64_t), ssize_t))
+            {
+                LS_MEMSET(pagemap_v, 0, sizeof(pagemap_v));
+            }
+
+            for (i = 0; i < batch_c; i++)
+            {
+                ls_u8_t flags = 0;
+
+                if (core_v[i] & 1)
+                {
+                    flags |= LS_VALLOC_PAGE_RESIDENT;
+                    stats->resident_bytes += page_size;
+                }
+
+                if ((pagemap_v[i] >> 62) & 1)  /* bit 62: page is swapped */
+                {
+                    flags |= LS_VALLOC_PAGE_SWAPPED;
+                    stats->swapped_bytes += page_size;
+                }
+
+                /* bits 0-54: pfn, zeroed for processes without CAP_SYS_ADMIN */
+                pfn = pagemap_v[i] & ((1llu << 55) - 1);
+
+                if ((pagemap_v[i] >> 63) && pfn != 0 && kpageflags_fd >= 0
+                    && pread(kpageflags_fd, &kpage_flags, sizeof(ls_u64_t), LS_CAST(pfn * sizeof(ls_u64_t), off_t)) == sizeof(ls_u64_t))
+                {
+                    pfn_visible = LS_TRUE;
+
+                    /* bit 17: hugetlbfs page, bit 22: transparent huge page */
+                    if (((kpage_flags >> 17) & 1) || ((kpage_flags >> 22) & 1))
+                    {
+                        flags |= LS_VALLOC_PAGE_HUGE;
+                        stats->huge_bytes += page_size;
+                    }
+                }
+
+                if (page_map != LS_NULL)
+                {
+                    page_map[page_i + i] = flags;
+                }
+            }
+        }
+
+        if (pagemap_fd >= 0)    close(pagemap_fd);
+        if (kpageflags_fd >= 0) close(kpageflags_fd);
+
+        if (!pfn_visible && stats->resident_bytes != 0)
+        {
+            stats->huge_bytes = _ls_valloc_smaps_huge_bytes(LS_CAST(ptr, ls_u64_t) + offset, LS_CAST(ptr, ls_u64_t) + end);
+
+            if (stats->huge_bytes > stats->resident_bytes)
+            {
+                stats->huge_bytes = stats->resident_bytes;
+            }
+        }
+    #endif
+
+    return LS_SUCCESS;
 }
 
-#endif
 
+static LS_INLINE ls_result_t ls_valloc_phint_range(ls_void_p ptr, ls_u64_t offset, ls_u64_t range, ls_u32_t hint)
+{
+    ls_u64_t page_size = _ls_valloc_page_size();
+    ls_u64_t end       = LS_ROUND_UP_TO(offset + range, page_size);
+    ls_u64_t size      = LS_ROUND_UP_TO(_ls_valloc_memtotal(), page_size);
 
-static LS_INLINE ls_u64_t _ls_valloc_page_size(void)
+    offset = LS_ROUND_DOWN_TO(offset, page_size);
+
+    if (end > size)
+    {
+        end = size;
+    }
+
+    if (offset >= end)
+    {
+        return LS_SUCCESS;  /* nothing to do */
+    }
+
+    return _ls_valloc_hint(LS_CAST(LS_CAST(ptr, ls_u64_t) + offset, ls_void_p), end - offset, hint);
+}
+
+static LS_INLINE ls_result_t _ls_valloc_hint(ls_void_p addr, ls_u64_t size, ls_u32_t hint)
 {
     #ifdef _WIN32
-        SYSTEM_INFO sysinfo;
-        GetSystemInfo(&sysinfo);
-    
-        return sysinfo.dwPageSize;
+        if (hint != LS_VALLOC_HINT_PAGEOUT)
+        {
+            return LS_FAIL;
+        }
+
+        /* unlocking pages that are not locked removes them from the working set */
+        VirtualUnlock(addr, size);
+
+        return LS_SUCCESS;
     #else
-        return sysconf(_SC_PAGESIZE);
+        int advice;
+
+        switch (hint)
+        {
+            #ifdef MADV_COLD
+            case LS_VALLOC_HINT_COLD:           advice = MADV_COLD;         break;
+            #endif
+            #ifdef MADV_PAGEOUT
+            case LS_VALLOC_HINT_PAGEOUT:        advice = MADV_PAGEOUT;      break;
+            #endif
+            #ifdef MADV_MERGEABLE
+            case LS_VALLOC_HINT_MERGEABLE:      advice = MADV_MERGEABLE;    break;
+            case LS_VALLOC_HINT_UNMERGEABLE:    advice = MADV_UNMERGEABLE;  break;
+            #endif
+            default:                            return LS_FAIL;
+        }
+
+        return (madvise(addr, size, advice) == 0) ? LS_SUCCESS : LS_FAIL;
     #endif
 }
 
 
-static LS_INLINE ls_u64_t _ls_valloc_memtotal(void)
+static LS_INLINE ls_result_t ls_valloc_access_sample(ls_void_p ptr, ls_u64_t offset, ls_u64_t range)
 {
     #ifdef _WIN32
-        MEMORYSTATUS memstat;
-        GlobalMemoryStatus(&memstat);
-    
-        return memstat.dwTotalPhys;
+        (void) ptr; (void) offset; (void) range;
+
+        return LS_FAIL;
     #else
-        FILE*  meminfo_f = fopen("/proc/meminfo", "rb");
-        ls_u64_t memtotal;
-    
-        fscanf(meminfo_f, "MemTotal:%lu", &memtotal);
-    
-        fclose(meminfo_f);
-    
-        return memtotal * 1024;
+        return _ls_valloc_access_scan(LS_CAST(ptr, ls_u64_t) + offset, LS_CAST(ptr, ls_u64_t) + offset + range, LS_TRUE, 0, LS_CAST(LS_NULL, ls_u64_p));
     #endif
 }
 
+static LS_INLINE ls_u64_t ls_valloc_access_apply(ls_void_p ptr, ls_u64_t offset, ls_u64_t range, ls_u32_t hint)
+{
+    #ifdef _WIN32
+        (void) ptr; (void) offset; (void) range; (void) hint;
+
+        return 0;
+    #else
+        ls_u64_t hinted = 0;
+
+        _ls_valloc_access_scan(LS_CAST(ptr, ls_u64_t) + offset, LS_CAST(ptr, ls_u64_t) + offset + range, LS_FALSE, hint, &hinted);
+
+        return hinted;
+    #endif
+}
+
+
+#ifndef _WIN32
+
+/*
+ * [mark] = LS_TRUE:  marks every page in [start, end) as not accessed
+ * [mark] = LS_FALSE: hints every run of resident pages that was not accessed since
+ */
+static LS_INLINE ls_result_t _ls_valloc_access_scan(ls_u64_t start, ls_u64_t end, ls_bool_t mark, ls_u32_t hint, ls_u64_p hinted)
+{
+    ls_u64_t page_size = _ls_valloc_page_size();
+    ls_u64_t pagemap_v[LS_VALLOC_RESIDENCY_BATCH];
+    ls_u64_t idle_word   = 0;
+    ls_u64_t idle_word_i = ~0llu;  /* word of 64 pfns [idle_word] holds, none yet */
+    ls_u64_t pfn;
+    ls_u64_t addr;
+    ls_u64_t batch_c;
+    ls_u64_t run_start = 0;
+    ls_u64_t run_end   = 0;
+    ls_u64_t i;
+    ls_bool_t cold;
+    int       pagemap_fd;
+    int       idle_fd;
+    int       clear_refs_fd;
+
+    start = LS_ROUND_DOWN_TO(start, page_size);
+    end   = LS_ROUND_UP_TO(end, page_size);
+
+    pagemap_fd = open("/proc/self/pagemap", O_RDONLY);
+
+    if (pagemap_fd < 0)
+    {
+        return LS_FAIL;
+    }
+
+    /* page_idle needs pfns, probe them with the (present) stack page of pagemap_v */
+    idle_fd = open("/sys/kernel/mm/page_idle/bitmap", O_RDWR);
+    pagemap_v[0] = 0;
+
+    if (idle_fd >= 0 && (pread(pagemap_fd, pagemap_v, sizeof(ls_u64_t), LS_CAST(LS_CAST(pagemap_v, ls_u64_t) / page_size * sizeof(ls_u64_t), off_t)) != sizeof(ls_u64_t)
+        || (pagemap_v[0] & ((1llu << 55) - 1)) == 0))
+    {
+        close(idle_fd);
+        idle_fd = -1;
+    }
+
+    #ifndef LS_VALLOC_ACCESS_WRITE_ONLY
+        /* soft-dirty bits miss reads, read-hot pages would be taken for cold ones */
+        if (idle_fd < 0)
+        {
+            close(pagemap_fd);
+
+            return LS_FAIL;
+        }
+    #endif
+
+    if (idle_fd < 0 && mark)
+    {
+        /* "4" clears the soft-dirty bits of the whole process */
+        clear_refs_fd = open("/proc/self/clear_refs", O_WRONLY);
+
+        if (clear_refs_fd < 0 || write(clear_refs_fd, "4", 1) != 1)
+        {
+            if (clear_refs_fd >= 0) close(clear_refs_fd);
+            close(pagemap_fd);
+
+            return LS_FAIL;
+        }
+
+        close(clear_refs_fd);
+        close(pagemap_fd);
+
+        return LS_SUCCESS;
+    }
+
+    for (addr = start; addr < end; addr += batch_c * page_size)
+    {
+        batch_c = (end - addr) / page_size;
+        batch_c = (batch_c > LS_VALLOC_RESIDENCY_BATCH) ? LS_VALLOC_RESIDENCY_BATCH : batch_c;
+
+        if (pread(pagemap_fd, pagemap_v, batch_c * sizeof(ls_u64_t), LS_CAST(addr / page_size * sizeof(ls_u64_t), off_t))
+            != LS_CAST(batch_c * sizeof(ls_u64_t), ssize_t))
+        {
+            LS_MEMSET(pagemap_v, 0, sizeof(pagemap_v));
+        }
+
+        for (i = 0; i < batch_c; i++)
+        {
+            pfn  = pagemap_v[i] & ((1llu << 55) - 1);
+            cold = LS_FALSE;
+
+            if (idle_fd >= 0 && (pagemap_v[i] >> 63) && pfn != 0)
+            {
+                /* one read or write per word of 64 pfns, neighbouring pages mostly share one */
+                if (mark && pfn / 64 != idle_word_i)
+                {
+                    if (idle_word_i != ~0llu)
+                    {
+                        /* set bits mark pages idle, clear bits are ignored */
+                        (void) !pwrite(idle_fd, &idle_word, sizeof(ls_u64_t), LS_CAST(idle_word_i * sizeof(ls_u64_t), off_t));
+                    }
+
+                    idle_word   = 0;
+                    idle_word_i = pfn / 64;
+                }
+                else if (!mark && pfn / 64 != idle_word_i)
+                {
+                    idle_word_i = pfn / 64;
+
+                    if (pread(idle_fd, &idle_word, sizeof(ls_u64_t), LS_CAST(idle_word_i * sizeof(ls_u64_t), off_t)) != sizeof(ls_u64_t))
+                    {
+                        idle_word = 0;
+                    }
+                }
+
+                if (mark)
+                {
+                    idle_word |= 1llu << (pfn % 64);
+                }
+                else
+                {
+                    cold = (idle_word >> (pfn % 64)) & 1;
+                }
+            }
+            else if (idle_fd < 0 && (pagemap_v[i] >> 63))
+            {
+                cold = !((pagemap_v[i] >> 55) & 1);  /* bit 55: soft-dirty */
+            }
+
+            if (mark)
+            {
+                continue;
+            }
+
+            if (cold)
+            {
+                if (run_end != addr + i * page_size)
+                {
+                    run_start = addr + i * page_size;
+                }
+
+                run_end = addr + (i + 1) * page_size;
+
+                continue;
+            }
+
+            if (run_end > run_start)
+            {
+                _ls_valloc_access_flush(run_start, run_end, hint, hinted);
+                run_start = run_end;
+            }
+        }
+    }
+
+    if (run_end > run_start)
+    {
+        _ls_valloc_access_flush(run_start, run_end, hint, hinted);
+    }
+
+    if (mark && idle_word_i != ~0llu)
+    {
+        (void) !pwrite(idle_fd, &idle_word, sizeof(ls_u64_t), LS_CAST(idle_word_i * sizeof(ls_u64_t), off_t));
+    }
+
+    if (idle_fd >= 0) close(idle_fd);
+    close(pagemap_fd);
+
+    return LS_SUCCESS;
+}
+
+static LS_INLINE void _ls_valloc_access_flush(ls_u64_t run_start, ls_u64_t run_end, ls_u32_t hint, ls_u64_p hinted)
+{
+    if (_ls_valloc_hint(LS_CAST(run_start, ls_void_p), run_end - run_start, hint) == LS_SUCCESS)
+    {
+        *hinted += run_end - run_start;
+    }
+}
+
+#endif
+
+
+static LS_INLINE ls_result_t ls_valloc_reclaim_register(ls_void_p ptr, ls_u64_t offset, ls_u64_t range, ls_u32_t priority, ls_valloc_reclaim_fn fn, ls_void_p user, ls_u32_p id)
+{
+    ls_u32_t i;
+
+    _ls_valloc_reclaim_lock();
+
+    for (i = 0; i < LS_VALLOC_RECLAIM_MAX; i++)
+    {
+        if (!_ls_valloc_reclaim_meta.entry_a[i].used)
+        {
+            break;
+        }
+    }
+
+    if (i == LS_VALLOC_RECLAIM_MAX)
+    {
+        _ls_valloc_reclaim_unlock();
+        return LS_FAIL;
+    }
+
+    _ls_valloc_reclaim_meta.entry_a[i].ptr      = ptr;
+    _ls_valloc_reclaim_meta.entry_a[i].offset   = offset;
+    _ls_valloc_reclaim_meta.entry_a[i].range    = range;
+    _ls_valloc_reclaim_meta.entry_a[i].priority = priority;
+    _ls_valloc_reclaim_meta.entry_a[i].fn       = fn;
+    _ls_valloc_reclaim_meta.entry_a[i].user     = user;
+    _ls_valloc_reclaim_meta.entry_a[i].used     = LS_TRUE;
+
+    _ls_valloc_reclaim_unlock();
+
+    *id = i;
+
+    return LS_SUCCESS;
+}
+
+static LS_INLINE void ls_valloc_reclaim_unregister(ls_u32_t id)
+{
+    if (id >= LS_VALLOC_RECLAIM_MAX)
+    {
+        return;
+    }
+
+    _ls_valloc_reclaim_lock();
+
+    _ls_valloc_reclaim_meta.entry_a[id].used = LS_FALSE;
+
+    _ls_valloc_reclaim_unlock();
+}
+
+
+static LS_INLINE ls_u64_t ls_valloc_reclaim_run(ls_u64_t target)
+{
+    ls_u32_t              order_a[LS_VALLOC_RECLAIM_MAX];
+    ls_u32_t              order_c = 0;
+    ls_u32_t              i;
+    ls_u32_t              j;
+    ls_u64_t              released  = 0;
+    ls_u64_t              page_size = _ls_valloc_page_size();
+    ls_u64_t              start;
+    ls_u64_t              end;
+    ls_valloc_residency_s stats;
+
+    _ls_valloc_reclaim_lock();
+
+    /* insertion sort by priority, lowest first */
+    for (i = 0; i < LS_VALLOC_RECLAIM_MAX; i++)
+    {
+        if (!_ls_valloc_reclaim_meta.entry_a[i].used)
+        {
+            continue;
+        }
+
+        for (j = order_c; j > 0 && _ls_valloc_reclaim_meta.entry_a[order_a[j - 1]].priority > _ls_valloc_reclaim_meta.entry_a[i].priority; j--)
+        {
+            order_a[j] = order_a[j - 1];
+        }
+
+        order_a[j] = i;
+        order_c++;
+    }
+
+    for (i = 0; i < order_c && released < target; i++)
+    {
+        _ls_valloc_reclaim_entry_s *entry = &_ls_valloc_reclaim_meta.entry_a[order_a[i]];
+
+        /* counted over the whole pages pfree_range releases, partial pages at the edges stay */
+        start = LS_ROUND_UP_TO(entry->offset, page_size);
+        end   = LS_ROUND_DOWN_TO(entry->offset + entry->range, page_size);
+
+        /* ranges that were already released are skipped */
+        if (start >= end || ls_valloc_residency(entry->ptr, start, end - start, &stats, LS_CAST(LS_NULL, ls_u8_p)) != LS_SUCCESS || stats.resident_bytes == 0)
+        {
+            continue;
+        }
+
+        if (entry->fn != LS_NULL && !entry->fn(entry->ptr, entry->offset, entry->range, entry->user))
+        {
+            continue;
+        }
+
+        ls_valloc_pfree_range(entry->ptr, entry->offset, entry->range);
+
+        released += stats.resident_bytes;
+    }
+
+    _ls_valloc_reclaim_unlock();
+
+    return released;
+}
+
+
+static LS_INLINE ls_result_t ls_valloc_reclaim_start(const char *source)
+{
+    if (_ls_valloc_reclaim_running())
+    {
+        return LS_FAIL;
+    }
+
+    if (_ls_valloc_reclaim_meta.started)
+    {
+        _ls_valloc_reclaim_join();  /* the last monitor exited on its own */
+    }
+
+    #ifdef _WIN32
+        (void) source;
+
+        _ls_valloc_reclaim_meta.wake_event = CreateEvent(LS_NULL, FALSE, FALSE, LS_NULL);
+        _ls_valloc_reclaim_meta.stop_event = CreateEvent(LS_NULL, TRUE,  FALSE, LS_NULL);
+
+        /* set before the thread starts, it may clear it right away */
+        _ls_valloc_reclaim_set_running(LS_TRUE);
+
+        _ls_valloc_reclaim_meta.thread     = CreateThread(LS_NULL, 0, _ls_valloc_reclaim_monitor, LS_NULL, 0, LS_NULL);
+
+        if (_ls_valloc_reclaim_meta.thread == LS_NULL)
+        {
+            _ls_valloc_reclaim_set_running(LS_FALSE);
+            CloseHandle(_ls_valloc_reclaim_meta.wake_event);
+            CloseHandle(_ls_valloc_reclaim_meta.stop_event);
+            return LS_FAIL;
+        }
+    #else
+        _ls_valloc_reclaim_meta.source_fd     = -1;
+        _ls_valloc_reclaim_meta.source_events = LS_FALSE;
+        _ls_valloc_reclaim_meta.event_c       = 0;
+
+        if (source == LS_NULL)
+        {
+            source = "/proc/pressure/memory";
+        }
+
+        snprintf(_ls_valloc_reclaim_meta.source, sizeof(_ls_valloc_reclaim_meta.source), "%s", source);
+
+        #ifdef __linux__
+            if (strstr(source, "memory.events") != LS_NULL)
+            {
+                _ls_valloc_reclaim_meta.source_events = LS_TRUE;
+                _ls_valloc_reclaim_meta.source_fd     = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+
+                if (_ls_valloc_reclaim_meta.source_fd < 0 || inotify_add_watch(_ls_valloc_reclaim_meta.source_fd, source, IN_MODIFY) < 0)
+                {
+                    if (_ls_valloc_reclaim_meta.source_fd >= 0) close(_ls_valloc_reclaim_meta.source_fd);
+                    return LS_FAIL;
+                }
+
+                _ls_valloc_reclaim_meta.event_c = _ls_valloc_reclaim_event_c();
+            }
+            else
+            {
+                _ls_valloc_reclaim_meta.source_fd = open(source, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+
+                if (_ls_valloc_reclaim_meta.source_fd < 0 || write(_ls_valloc_reclaim_meta.source_fd, LS_VALLOC_PSI_TRIGGER, sizeof(LS_VALLOC_PSI_TRIGGER)) < 0)
+                {
+                    if (_ls_valloc_reclaim_meta.source_fd >= 0) close(_ls_valloc_reclaim_meta.source_fd);
+                    return LS_FAIL;
+                }
+            }
+        #endif
+
+        if (pipe(_ls_valloc_reclaim_meta.wake_fd) != 0)
+        {
+            if (_ls_valloc_reclaim_meta.source_fd >= 0) close(_ls_valloc_reclaim_meta.source_fd);
+            return LS_FAIL;
+        }
+
+        _ls_valloc_reclaim_set_running(LS_TRUE);
+
+        if (pthread_create(&_ls_valloc_reclaim_meta.thread, LS_CAST(LS_NULL, pthread_attr_t *), _ls_valloc_reclaim_monitor, LS_NULL) != 0)
+        {
+            _ls_valloc_reclaim_set_running(LS_FALSE);
+            if (_ls_valloc_reclaim_meta.source_fd >= 0) close(_ls_valloc_reclaim_meta.source_fd);
+            close(_ls_valloc_reclaim_meta.wake_fd[0]);
+            close(_ls_valloc_reclaim_meta.wake_fd[1]);
+            return LS_FAIL;
+        }
+    #endif
+
+    _ls_valloc_reclaim_meta.started = LS_TRUE;
+
+    return LS_SUCCESS;
+}
+
+static LS_INLINE void ls_valloc_reclaim_trigger(void)
+{
+    if (!_ls_valloc_reclaim_running())
+    {
+        return;
+    }
+
+    #ifdef _WIN32
+        SetEvent(_ls_valloc_reclaim_meta.wake_event);
+    #else
+        char wake = 1;
+        (void) !write(_ls_valloc_reclaim_meta.wake_fd[1], &wake, 1);
+    #endif
+}
+
+static LS_INLINE void ls_valloc_reclaim_stop(void)
+{
+    if (!_ls_valloc_reclaim_meta.started)
+    {
+        return;
+    }
+
+    _ls_valloc_reclaim_join();
+}
+
+
+static LS_INLINE void _ls_valloc_reclaim_lock(void)
+{
+    #ifdef _WIN32
+        AcquireSRWLockExclusive(&_ls_valloc_reclaim_mutex);
+    #else
+        pthread_mutex_lock(&_ls_valloc_reclaim_mutex);
+    #endif
+}
+
+static LS_INLINE void _ls_valloc_reclaim_unlock(void)
+{
+    #ifdef _WIN32
+        ReleaseSRWLockExclusive(&_ls_valloc_reclaim_mutex);
+    #else
+        pthread_mutex_unlock(&_ls_valloc_reclaim_mutex);
+    #endif
+}
+
+static LS_INLINE ls_bool_t _ls_valloc_reclaim_running(void)
+{
+    #ifdef _WIN32
+        return InterlockedCompareExchange(&_ls_valloc_reclaim_meta.running, 0, 0) != 0;
+    #else
+        return __atomic_load_n(&_ls_valloc_reclaim_meta.running, __ATOMIC_ACQUIRE);
+    #endif
+}
+
+static LS_INLINE void _ls_valloc_reclaim_set_running(ls_bool_t running)
+{
+    #ifdef _WIN32
+        InterlockedExchange(&_ls_valloc_reclaim_meta.running, running ? 1 : 0);
+    #else
+        __atomic_store_n(&_ls_valloc_reclaim_meta.running, running, __ATOMIC_RELEASE);
+    #endif
+}
+
+/* stops the monitor if it still runs, waits for it to exit and releases what start acquired */
+static LS_INLINE void _ls_valloc_reclaim_join(void)
+{
+    #ifdef _WIN32
+        SetEvent(_ls_valloc_reclaim_meta.stop_event);
+        WaitForSingleObject(_ls_valloc_reclaim_meta.thread, INFINITE);
+
+        CloseHandle(_ls_valloc_reclaim_meta.thread);
+        CloseHandle(_ls_valloc_reclaim_meta.wake_event);
+        CloseHandle(_ls_valloc_reclaim_meta.stop_event);
+    #else
+        char stop = 0;  /* a 0 byte on the wake pipe tells the monitor to exit */
+        (void) !write(_ls_valloc_reclaim_meta.wake_fd[1], &stop, 1);
+
+        pthread_join(_ls_valloc_reclaim_meta.thread, LS_CAST(LS_NULL, void **));
+
+        if (_ls_valloc_reclaim_meta.source_fd >= 0) close(_ls_valloc_reclaim_meta.source_fd);
+        close(_ls_valloc_reclaim_meta.wake_fd[0]);
+        close(_ls_valloc_reclaim_meta.wake_fd[1]);
+    #endif
+
+    _ls_valloc_reclaim_set_running(LS_FALSE);
+    _ls_valloc_reclaim_meta.started = LS_FALSE;
+}
+
+
+/* blocks until pressure is reported (LS_TRUE) or the monitor is stopped (LS_FALSE) */
+static LS_INLINE ls_bool_t _ls_valloc_reclaim_wait(void)
+{
+    #ifdef _WIN32
+        HANDLE   handle_a[3];
+        DWORD    handle_c = 2;
+        DWORD    waited;
+
+        handle_a[0] = _ls_valloc_reclaim_meta.stop_event;
+        handle_a[1] = _ls_valloc_reclaim_meta.wake_event;
+        handle_a[2] = CreateMemoryResourceNotification(LowMemoryResourceNotification);
+
+        if (handle_a[2] != LS_NULL)
+        {
+            handle_c = 3;
+        }
+
+        waited = WaitForMultipleObjects(handle_c, handle_a, FALSE, INFINITE);
+
+        if (handle_a[2] != LS_NULL)
+        {
+            CloseHandle(handle_a[2]);
+        }
+
+        if (waited == WAIT_OBJECT_0 + 2)
+        {
+            /* the notification stays signaled while memory is low, give the last step time to show */
+            return WaitForSingleObject(_ls_valloc_reclaim_meta.stop_event, 1000) != WAIT_OBJECT_0;
+        }
+
+        return waited == WAIT_OBJECT_0 + 1;
+    #else
+        struct pollfd poll_a[2];
+        char          wake;
+
+        for (;;)
+        {
+            poll_a[0].fd      = _ls_valloc_reclaim_meta.wake_fd[0];
+            poll_a[0].events  = POLLIN;
+            poll_a[0].revents = 0;
+            poll_a[1].fd      = _ls_valloc_reclaim_meta.source_fd;
+            poll_a[1].events  = _ls_valloc_reclaim_meta.source_events ? POLLIN : POLLPRI;
+            poll_a[1].revents = 0;
+
+            if (poll(poll_a, 2, -1) < 0)
+            {
+                continue;
+            }
+
+            if (poll_a[0].revents & POLLIN)
+            {
+                if (read(_ls_valloc_reclaim_meta.wake_fd[0], &wake, 1) != 1 || wake == 0)
+                {
+                    return LS_FALSE;
+                }
+
+                return LS_TRUE;
+            }
+
+            if (poll_a[1].revents & POLLERR)
+            {
+                return LS_FALSE;  /* the pressure source went away */
+            }
+
+            #ifdef __linux__
+                if (_ls_valloc_reclaim_meta.source_events)
+                {
+                    char     inotify_buf[4096];
+                    ls_u64_t event_c;
+
+                    while (read(_ls_valloc_reclaim_meta.source_fd, inotify_buf, sizeof(inotify_buf)) > 0)
+                    {
+                        ;  /* drain */
+                    }
+
+                    event_c = _ls_valloc_reclaim_event_c();
+
+                    if (event_c == _ls_valloc_reclaim_meta.event_c)
+                    {
+                        continue;  /* modified, but no new pressure event */
+                    }
+
+                    _ls_valloc_reclaim_meta.event_c = event_c;
+                }
+            #endif
+
+            return LS_TRUE;
+        }
+    #endif
+}
+
+#ifdef __linux__
+
+/* sum of the high, max and oom counters of a cgroup memory.events file */
+static LS_INLINE ls_u64_t _ls_valloc_reclaim_event_c(void)
+{
+    FILE*    events_f = fopen(_ls_valloc_reclaim_meta.source, "rb");
+    char     line[64];
+    ls_u64_t value;
+    ls_u64_t event_c  = 0;
+
+    if (events_f == LS_NULL)
+    {
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), events_f) != LS_NULL)
+    {
+        if (sscanf(line, "high %lu", &value) == 1 || sscanf(line, "max %lu", &value) == 1
+            || sscanf(line, "oom %lu", &value) == 1)
+        {
+            event_c += value;
+        }
+    }
+
+    fclose(events_f);
+
+    return event_c;
+}
+
+#endif
+
+#ifdef _WIN32
+static DWORD WINAPI _ls_valloc_reclaim_monitor(LPVOID arg)
+#else
+static void *_ls_valloc_reclaim_monitor(void *arg)
+#endif
+{
+    (void) arg;
+
+    while (_ls_valloc_reclaim_wait())
+    {
+        ls_valloc_reclaim_run(LS_VALLOC_RECLAIM_STEP);
+    }
+
+    /* stopped, or the source went away: triggers are no longer served either way */
+    _ls_valloc_reclaim_set_running(LS_FALSE);
+
+    #ifdef _WIN32
+        return 0;
+    #else
+        return LS_NULL;
+    #endif
+}
+
+
+#ifdef _WIN32
+
+static LS_INLINE void _ls_valloc_pcommit_range_win32(ls_void_p ptr, ls_u64_t offset, ls_u64_t range)
+{
+    ls_u64_t page_size = _ls_valloc_page_size();
+    ls_u64_t end;
+
+    if (range == 0)
+    {
+        return;  /* nothing to do */
+    }
+
+    /* round the end up before the start moves down, or a range crossing a page boundary loses its tail */
+    end    = LS_ROUND_UP_TO(offset + range, page_size);
+    offset = LS_ROUND_DOWN_TO(offset, page_size);
+    range  = end - offset;
+    
+    if (offset >= _ls_valloc_memtotal())
+    {
+        return;  /* nothing to do */
+    }
+    
+    if (offset + range > _ls_valloc_memtotal())
+    {
+        range = _ls_valloc_memtotal() - offset;
+    }
+    
+    VirtualAlloc(LS_CAST(LS_CAST(ptr, ls_u64_t) + offset, ls_void_p), range, MEM_COMMIT, PAGE_READWRITE);
+}
+
+#endif
+
+
+static LS_INLINE ls_u64_t _ls_valloc_page_size(void)
+{
+    #ifdef _WIN32
+        SYSTEM_INFO sysinfo;
+        GetSystemInfo(&sysinfo);
+    
+        return sysinfo.dwPageSize;
+    #else
+        return sysconf(_SC_PAGESIZE);
+    #endif
+}
+
+
+static LS_INLINE ls_u64_t _ls_valloc_memtotal(void)
+{
+    #ifdef _WIN32
+        MEMORYSTATUS memstat;
+        GlobalMemoryStatus(&memstat);
+    
+        return memstat.dwTotalPhys;
+    #else
+        /* read once, every pfree_range would parse /proc/meminfo again. vfree must unmap the size valloc mapped anyway */
+        static ls_u64_t memtotal_cache;
+        FILE*  meminfo_f;
+        ls_u64_t memtotal = __atomic_load_n(&memtotal_cache, __ATOMIC_RELAXED);
+
+        if (memtotal)
+        {
+            return memtotal;
+        }
+
+        meminfo_f = fopen("/proc/meminfo", "rb");
+    
+        fscanf(meminfo_f, "MemTotal:%lu", &memtotal);
+    
+        fclose(meminfo_f);
+
+        __atomic_store_n(&memtotal_cache, memtotal * 1024, __ATOMIC_RELAXED);
+    
+        return memtotal * 1024;
+    #endif
+}
+
+
+#ifndef _WIN32
+
+static LS_INLINE ls_u64_t _ls_valloc_smaps_huge_bytes(ls_u64_t start, ls_u64_t end)
+{
+    FILE*     smaps_f     = fopen("/proc/self/smaps", "rb");
+    char      line[256];
+    ls_u64_t  vma_start;
+    ls_u64_t  vma_end;
+    ls_u64_t  huge_kb;
+    ls_u64_t  huge_bytes  = 0;
+    ls_bool_t overlapping = LS_FALSE;
+
+    if (smaps_f == LS_NULL)
+    {
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), smaps_f) != LS_NULL)
+    {
+        /* mapping headers start with "start-end", field lines with a name */
+        if (sscanf(line, "%lx-%lx ", &vma_start, &vma_end) == 2)
+        {
+            overlapping = vma_start < end && vma_end > start;
+        }
+        else if (overlapping && sscanf(line, "AnonHugePages: %lu kB", &huge_kb) == 1)
+        {
+            huge_bytes += huge_kb * 1024;
+        }
+    }
+
+    fclose(smaps_f);
+
+    return huge_bytes;
+}
+
+#endif
+
 
 #endif  /* #ifdef LS_VALLOC_H */
 
@@ -0,0 +1,355 @@
+/*
+ * ls_vec.h - v1.0.0 - growable vector - Logan Seeley 2025
+ *
+ * Documentation
+ *
+ *	Behaviour & Safety
+ *
+ *		A vector keeps its elements in one block of [ls_lalloc.h]. Blocks
+ *		are powers of 2, so growing past the block asks [ls_relalloc] for
+ *		the next one up and capacity doubles on its own. Blocks of at least
+ *		LS_LALLOC_MEMCPY_THRES are moved by remapping their pages instead of
+ *		copying them, so growing a large vector costs the same at any size.
+ *		The capacity is always the whole block ([ls_lalloc_usable_size]),
+ *		never just what was asked for, so no growth happens while it fits.
+ *
+ *		Elements move by their bytes, they must be trivially relocatable.
+ *		A vector never shrinks, its block is only given back by fini.
+ *		Vectors are not thread-safe.
+ *
+ *	Usage
+ *
+ *		Requires [ls_lalloc.h], with its implementation (LS_LALLOC_IMPL)
+ *		in one translation unit and _GNU_SOURCE defined on linux.
+ *
+ *		LS_VEC_DEFINE(name, type) defines a vector of [type] for C:
+ *		the type [name_s] and the functions below, prefixed [name_].
+ *		Use it once per element type, at file scope.
+ *
+ *		From C++, [ls::vector<T>] is a vector of T.
+ *
+ *	Functions
+ *
+ *		name_s name_init(void) - init
+ *			an empty vector, nothing is allocated until the first element.
+ *
+ *		void name_fini(name_s *vec) - fini
+ *
+ *		ls_result_t name_reserve(name_s *vec, ls_u64_t cap) - reserve
+ *			grows the block to hold at least [cap] elements.
+ *			Returns LS_FAIL if the block could not grow, [vec] is left as is.
+ *
+ *		ls_result_t name_push(name_s *vec, type value) - push
+ *			appends [value].
+ *			Returns LS_FAIL if the block could not grow, [vec] is left as is.
+ *
+ *		type name_pop(name_s *vec) - pop
+ *			removes and returns the last element, [vec] must not be empty.
+ *
+ *		type *name_at(name_s *vec, ls_u64_t i) - at
+ *			[i] must be below the length.
+ *
+ *		ls_u64_t name_len(name_s *vec) - len
+ *
+ *		ls_u64_t name_cap(name_s *vec) - cap
+ *
+ *		void name_clear(name_s *vec) - clear
+ *			drops every element, the block is kept.
+ *
+ *	C++
+ *
+ *		ls::vector<T>()
+ *			T must be trivially relocatable: trivially copyable types are,
+ *			specialize ls::is_trivially_relocatable<T> for the others (e.g. types
+ *			owning a pointer to the heap, never into themselves).
+ *			Movable, not copyable. The destructor destroys every element.
+ *
+ *		bool reserve(std::size_t cap)
+ *		bool push_back(const T &value) / bool push_back(T &&value)
+ *			false if the block could not grow, the vector is left as is.
+ *
+ *		T *emplace_back(Args &&...args)
+ *			nullptr if the block could not grow.
+ *
+ *		void pop_back() / void clear()
+ *			destroy the elements they drop.
+ *
+ *		size(), capacity(), empty(), data(), operator[], begin(), end()
+ */
+
+
+#ifndef LS_VEC_H
+#define LS_VEC_H
+
+
+#include "./ls_macros.h"
+#include "./ls_lalloc.h"
+
+
+#define LS_VEC_MAX_SIZE	0x10000000000llu  /* 1 TiB, the largest block of ls_lalloc */
+
+
+static ls_result_t		_ls_vec_reserve			(ls_void_p *data, 	ls_u64_p cap, 	ls_u64_t elem_size, 	ls_u64_t elem_c)	LS_LIBFN;
+
+
+/* grows [*data] to hold at least [elem_c] elements of [elem_size] bytes, [*cap] becomes the whole block */
+static LS_INLINE ls_result_t _ls_vec_reserve(ls_void_p *data, ls_u64_p cap, ls_u64_t elem_size, ls_u64_t elem_c)
+{
+	ls_void_p block;
+
+	if (elem_c <= *cap)
+	{
+		return LS_SUCCESS;
+	}
+
+	if (elem_c > LS_VEC_MAX_SIZE / elem_size)
+	{
+		return LS_FAIL;
+	}
+
+	/* rounded up to a power of 2, one element past a full block doubles it */
+	block = ls_relalloc(*data, elem_c * elem_size);
+
+	if (block == LS_NULL)
+	{
+		return LS_FAIL;
+	}
+
+	*data	= block;
+	*cap	= ls_lalloc_usable_size(block) / elem_size;
+
+	return LS_SUCCESS;
+}
+
+
+#define LS_VEC_DEFINE(name, type)																			\
+																											\
+	typedef struct																							\
+	{																										\
+		type	   *_data;																					\
+		ls_u64_t	_len;																					\
+		ls_u64_t	_cap;																					\
+	}																										\
+	name##_s;																								\
+																											\
+	static LS_INLINE name##_s name##_init(void)																\
+	{																										\
+		name##_s vec;																						\
+																											\
+		vec._data	= LS_CAST(LS_NULL, type *);																\
+		vec._len	= 0;																					\
+		vec._cap	= 0;																					\
+																											\
+		return vec;																							\
+	}																										\
+																											\
+	static LS_INLINE void name##_fini(name##_s *vec)														\
+	{																										\
+		if (vec->_data)																						\
+		{																									\
+			ls_lfree(vec->_data);																			\
+		}																									\
+																											\
+		vec->_data	= LS_CAST(LS_NULL, type *);																\
+		vec->_len	= 0;																					\
+		vec->_cap	= 0;																					\
+	}																										\
+																											\
+	static LS_INLINE ls_result_t name##_reserve(name##_s *vec, ls_u64_t cap)								\
+	{																										\
+		ls_void_p data = vec->_data;																		\
+		ls_result_t result = _ls_vec_reserve(&data, &vec->_cap, sizeof(type), cap);							\
+																											\
+		vec->_data = LS_CAST(data, type *);																	\
+																											\
+		return result;																						\
+	}																										\
+																											\
+	static LS_INLINE ls_result_t name##_push(name##_s *vec, type value)										\
+	{																										\
+		if (vec->_len == vec->_cap && name##_reserve(vec, vec->_len + 1) != LS_SUCCESS)						\
+		{																									\
+			return LS_FAIL;																					\
+		}																									\
+																											\
+		vec->_data[vec->_len++] = value;																	\
+																											\
+		return LS_SUCCESS;																					\
+	}																										\
+																											\
+	static LS_INLINE type name##_pop(name##_s *vec)															\
+	{																										\
+		return vec->_data[--vec->_len];																		\
+	}																										\
+																											\
+	static LS_INLINE type *name##_at(name##_s *vec, ls_u64_t i)												\
+	{																										\
+		return &vec->_data[i];																				\
+	}																										\
+																											\
+	static LS_INLINE ls_u64_t name##_len(name##_s *vec)														\
+	{																										\
+		return vec->_len;																					\
+	}																										\
+																											\
+	static LS_INLINE ls_u64_t name##_cap(name##_s *vec)														\
+	{																										\
+		return vec->_cap;																					\
+	}																										\
+																											\
+	static LS_INLINE void name##_clear(name##_s *vec)														\
+	{																										\
+		vec->_len = 0;																						\
+	}
+
+
+#ifdef __cplusplus
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ls
+{
+	template <typename T>
+	struct is_trivially_relocatable : std::is_trivially_copyable<T>
+	{
+	};
+
+	template <typename T>
+	class vector
+	{
+		static_assert(is_trivially_relocatable<T>::value, "ls::vector<T> moves elements by their bytes, specialize ls::is_trivially_relocatable<T>");
+
+	public:
+		vector()
+			: _data(nullptr), _len(0), _cap(0)
+		{
+		}
+
+		~vector()
+		{
+			clear();
+
+			if (_data)
+			{
+				ls_lfree(_data);
+			}
+		}
+
+		vector(const vector &) = delete;
+		vector &operator=(const vector &) = delete;
+
+		vector(vector &&other) noexcept
+			: _data(other._data), _len(other._len), _cap(other._cap)
+		{
+			other._data = nullptr;
+			other._len	= 0;
+			other._cap	= 0;
+		}
+
+		vector &operator=(vector &&other) noexcept
+		{
+			if (this != &other)
+			{
+				this->~vector();
+				new (this) vector(std::move(other));
+			}
+
+			return *this;
+		}
+
+		bool reserve(std::size_t cap)
+		{
+			ls_void_p data = _data;
+			ls_result_t result = _ls_vec_reserve(&data, &_cap, sizeof(T), cap);
+
+			_data = static_cast<T *>(data);
+
+			return result == LS_SUCCESS;
+		}
+
+		bool push_back(const T &value)
+		{
+			return emplace_back(value) != nullptr;
+		}
+
+		bool push_back(T &&value)
+		{
+			return emplace_back(std::move(value)) != nullptr;
+		}
+
+		template <typename... Args>
+		T *emplace_back(Args &&...args)
+		{
+			if (_len == _cap && !reserve(_len + 1))
+			{
+				return nullptr;
+			}
+
+			/* only counted once constructed, a throwing constructor leaves the vector as is */
+			T *object = new (_data + _len) T(std::forward<Args>(args)...);
+
+			_len++;
+
+			return object;
+		}
+
+		void pop_back()
+		{
+			_data[--_len].~T();
+		}
+
+		void clear()
+		{
+			while (_len)
+			{
+				pop_back();
+			}
+		}
+
+		std::size_t size() const		{ return _len; }
+		std::size_t capacity() const	{ return _cap; }
+		bool empty() const				{ return _len == 0; }
+
+		T *data()						{ return _data; }
+		const T *data() const			{ return _data; }
+
+		T &operator[](std::size_t i)				{ return _data[i]; }
+		const T &operator[](std::size_t i) const	{ return _data[i]; }
+
+		T *begin()						{ return _data; }
+		T *end()						{ return _data + _len; }
+		const T *begin() const			{ return _data; }
+		const T *end() const			{ return _data + _len; }
+
+	private:
+		T		   *_data;
+		ls_u64_t	_len;
+		ls_u64_t	_cap;
+	};
+}
+
+#endif  /* #ifdef __cplusplus */
+
+
+#endif  /* #ifndef LS_VEC_H */
+
+
+/*
+ * Copyright (C) 2025  Logan Seeley
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
@@ -0,0 +1,219 @@
+/*
+ * ls_chunk_arena_atomic_test.c - stress test & bench of the _atomic chunk arena functions
+ *
+ *	Build & run
+ *
+ *		cc -std=c11 -O2 -pthread tests/ls_chunk_arena_atomic_test.c -o atomic_test
+ *		./atomic_test [thread_c]
+ *
+ *	Every thread gets and deletes chunks with get_chunk_atomic and
+ *	delete_chunk_atomic, claiming each chunk in an owner table while
+ *	holding it. Fails on a chunk handed out twice, a held chunk written
+ *	by someone else, chunks lost once all threads are done or a live
+ *	count other than 0. Then runs the same loop on get_chunk and
+ *	delete_chunk behind a mutex and prints the throughput of both.
+ */
+
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* the memory is static, nothing to commit */
+#define _ls_chunk_arena_alloca_commit_range(memory, offset, range)
+
+#include "../ls_chunk_arena.h"
+
+
+#define TEST_CHUNK_SIZE		64
+#define TEST_MEMORY_SIZE	(1 << 20)
+#define TEST_HELD_C			16
+#define TEST_ROUND_C		20000
+#define TEST_THREAD_MAX_C	64
+
+
+static _Alignas(TEST_CHUNK_SIZE) ls_u8_t memory[TEST_MEMORY_SIZE];
+
+static ls_chunk_arena_s	arena;
+static pthread_mutex_t	arena_lock = PTHREAD_MUTEX_INITIALIZER;
+static ls_u32_t			owner_a[TEST_MEMORY_SIZE / TEST_CHUNK_SIZE];
+static ls_u32_t			error_c;
+
+
+static ls_void_p test_get(ls_bool_t locked)
+{
+	ls_result_t	status;
+	ls_void_p	chunk;
+
+	if (!locked)
+	{
+		return ls_chunk_arena_get_chunk_atomic(&arena, &status);
+	}
+
+	pthread_mutex_lock(&arena_lock);
+	chunk = ls_chunk_arena_get_chunk(&arena, &status);
+	pthread_mutex_unlock(&arena_lock);
+
+	return chunk;
+}
+
+
+static void test_delete(ls_void_p chunk, ls_bool_t locked)
+{
+	if (!locked)
+	{
+		ls_chunk_arena_delete_chunk_atomic(&arena, chunk);
+		return;
+	}
+
+	pthread_mutex_lock(&arena_lock);
+	ls_chunk_arena_delete_chunk(&arena, chunk);
+	pthread_mutex_unlock(&arena_lock);
+}
+
+
+static void *test_worker(void *arg)
+{
+	ls_u32_t	id		= LS_CAST(LS_CAST(arg, ls_u64_t), ls_u32_t) >> 1;
+	ls_bool_t	locked	= LS_CAST(arg, ls_u64_t) & 1;
+	ls_u64_p	held_a[TEST_HELD_C];
+	ls_u64_t	chunk_i;
+	ls_u32_t	round_i;
+	ls_u32_t	held_i;
+	ls_u32_t	free_owner;
+
+	for (round_i = 0; round_i < TEST_ROUND_C; round_i++)
+	{
+		for (held_i = 0; held_i < TEST_HELD_C; held_i++)
+		{
+			held_a[held_i] = LS_CAST(test_get(locked), ls_u64_p);
+
+			if (held_a[held_i] == LS_NULL)
+			{
+				__atomic_add_fetch(&error_c, 1, __ATOMIC_RELAXED);
+				printf("arena full with %u chunks per thread held\n", TEST_HELD_C);
+				return LS_NULL;
+			}
+
+			chunk_i		= LS_CHUNK_ARENA_ADDR_TO_INDEX((&arena), held_a[held_i]);
+			free_owner	= 0;
+
+			if (!__atomic_compare_exchange_n(&owner_a[chunk_i], &free_owner, id, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			{
+				__atomic_add_fetch(&error_c, 1, __ATOMIC_RELAXED);
+				printf("chunk %llu handed to thread %u while held by thread %u\n",
+					LS_CAST(chunk_i, unsigned long long), id, free_owner);
+			}
+
+			*held_a[held_i] = LS_CAST(held_a[held_i], ls_u64_t) ^ id;
+		}
+
+		for (held_i = 0; held_i < TEST_HELD_C; held_i++)
+		{
+			if (*held_a[held_i] != (LS_CAST(held_a[held_i], ls_u64_t) ^ id))
+			{
+				__atomic_add_fetch(&error_c, 1, __ATOMIC_RELAXED);
+				printf("chunk %p overwritten while held by thread %u\n", LS_CAST(held_a[held_i], void *), id);
+			}
+
+			chunk_i = LS_CHUNK_ARENA_ADDR_TO_INDEX((&arena), held_a[held_i]);
+			__atomic_store_n(&owner_a[chunk_i], 0, __ATOMIC_RELEASE);
+
+			test_delete(held_a[held_i], locked);
+		}
+	}
+
+	return LS_NULL;
+}
+
+
+static double test_run(ls_u32_t thread_c, ls_bool_t locked)
+{
+	pthread_t		thread_a[TEST_THREAD_MAX_C];
+	struct timespec	start;
+	struct timespec	end;
+	ls_u32_t		thread_i;
+
+	arena = ls_chunk_arena_init(memory, TEST_MEMORY_SIZE, TEST_CHUNK_SIZE);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (thread_i = 0; thread_i < thread_c; thread_i++)
+	{
+		pthread_create(&thread_a[thread_i], LS_NULL, test_worker, LS_CAST(LS_CAST(((thread_i + 1) << 1) | locked, ls_u64_t), void *));
+	}
+
+	for (thread_i = 0; thread_i < thread_c; thread_i++)
+	{
+		pthread_join(thread_a[thread_i], LS_NULL);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+
+/* every chunk the arena can hold must still be obtainable once the threads are done */
+static void test_check_lost(const char *name)
+{
+	ls_result_t	status;
+	ls_u64_t	chunk_c = 0;
+
+	if (arena._chunk_c != 0)
+	{
+		error_c++;
+		printf("%s: %llu chunks still counted live\n", name, LS_CAST(arena._chunk_c, unsigned long long));
+	}
+
+	while (ls_chunk_arena_get_chunk(&arena, &status) != LS_NULL)
+	{
+		chunk_c++;
+	}
+
+	if (chunk_c != arena._max_chunk_c)
+	{
+		error_c++;
+		printf("%s: %llu of %llu chunks obtainable\n", name,
+			LS_CAST(chunk_c, unsigned long long), LS_CAST(arena._max_chunk_c, unsigned long long));
+	}
+}
+
+
+int main(int argc, char **argv)
+{
+	ls_u32_t	thread_c	= (argc > 1) ? LS_CAST(atoi(argv[1]), ls_u32_t) : 4;
+	ls_u64_t	op_c;
+	double		atomic_s;
+	double		locked_s;
+
+	if (thread_c == 0 || thread_c > TEST_THREAD_MAX_C)
+	{
+		printf("thread count must be 1 to %u\n", TEST_THREAD_MAX_C);
+		return 2;
+	}
+
+	op_c = LS_CAST(thread_c, ls_u64_t) * TEST_ROUND_C * TEST_HELD_C * 2;
+
+	atomic_s = test_run(thread_c, 0);
+	test_check_lost("atomic");
+
+	locked_s = test_run(thread_c, 1);
+	test_check_lost("locked");
+
+	printf("%u threads, %llu get/delete calls\n", thread_c, LS_CAST(op_c, unsigned long long));
+	printf("  atomic: %8.2f Mop/s\n", op_c / atomic_s / 1e6);
+	printf("  locked: %8.2f Mop/s\n", op_c / locked_s / 1e6);
+
+	if (error_c)
+	{
+		printf("FAIL: %u errors\n", error_c);
+		return 1;
+	}
+
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,169 @@
+/*
+ * ls_chunk_arena_magazine_test.c - test of magazines handing chunks back to the locked functions
+ *
+ *	Build & run
+ *
+ *		cc -std=c11 -O2 tests/ls_chunk_arena_magazine_test.c -o magazine_test
+ *		./magazine_test
+ *
+ *	Takes every chunk through a magazine, deletes them all into it and
+ *	flushes it, which leaves a batch in the depot. Then takes every chunk
+ *	again with the non _atomic functions and checks that each lies below
+ *	the metadata, none is handed out twice and the arena is full after
+ *	exactly as many as it holds. Compaction must run with the depot filled
+ *	the same way.
+ */
+
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+
+/* the memory is static, nothing to commit */
+#define _ls_chunk_arena_alloca_commit_range(memory, offset, range)
+
+#include "../ls_chunk_arena.h"
+
+
+#define TEST_CHUNK_SIZE		64
+#define TEST_CHUNK_C		100
+
+
+static _Alignas(TEST_CHUNK_SIZE) ls_u8_t memory[TEST_CHUNK_C * TEST_CHUNK_SIZE];
+
+static ls_void_p	chunk_a[TEST_CHUNK_C];
+static ls_u8_t		taken_a[TEST_CHUNK_C];
+static ls_u32_t		error_c;
+
+
+#define TEST_CHECK(cond, ...)		\
+	do								\
+	{								\
+		if (!(cond))				\
+		{							\
+			error_c++;				\
+			printf(__VA_ARGS__);	\
+			printf("\n");			\
+		}							\
+	}								\
+	while (0)
+
+
+/* takes every chunk through [magazine], deletes them all into it and flushes it */
+static void test_fill_depot(ls_chunk_arena_s *arena, ls_chunk_arena_magazine_s *magazine, ls_u64_t chunk_c)
+{
+	ls_result_t	status;
+	ls_u64_t	i;
+
+	for (i = 0; i < chunk_c; i++)
+	{
+		chunk_a[i] = ls_chunk_arena_magazine_get_chunk(arena, magazine, &status);
+		TEST_CHECK(status == LS_SUCCESS, "fill: magazine get %llu failed", LS_CAST(i, unsigned long long));
+	}
+
+	for (i = 0; i < chunk_c; i++)
+	{
+		ls_chunk_arena_magazine_delete_chunk(arena, magazine, chunk_a[i]);
+	}
+
+	ls_chunk_arena_magazine_flush(arena, magazine);
+
+	TEST_CHECK(LS_CHUNK_ARENA_FREE_INDEX(arena->_depot) != 0, "fill: flushing left the depot empty, nothing is tested");
+}
+
+
+static void test_get_after_flush(void)
+{
+	ls_chunk_arena_s			arena		= ls_chunk_arena_init(memory, sizeof(memory), TEST_CHUNK_SIZE);
+	ls_chunk_arena_magazine_s	magazine	= ls_chunk_arena_magazine_init();
+	ls_result_t					status;
+	ls_void_p					chunk_p;
+	ls_u64_t					chunk_i;
+	ls_u64_t					chunk_c		= 0;
+
+	test_fill_depot(&arena, &magazine, arena._max_chunk_c);
+
+	while ((chunk_p = ls_chunk_arena_get_chunk(&arena, &status)) != LS_NULL)
+	{
+		chunk_i = LS_CHUNK_ARENA_ADDR_TO_INDEX((&arena), chunk_p);
+
+		if (chunk_i >= arena._max_chunk_c)
+		{
+			TEST_CHECK(0, "get: chunk %llu handed out at index %llu, inside the metadata",
+				LS_CAST(chunk_c, unsigned long long), LS_CAST(chunk_i, unsigned long long));
+			return;
+		}
+
+		TEST_CHECK(!taken_a[chunk_i], "get: chunk %llu handed out twice", LS_CAST(chunk_i, unsigned long long));
+
+		taken_a[chunk_i] = 1;
+		chunk_c++;
+	}
+
+	TEST_CHECK(status == LS_CHUNK_ARENA_MEM_FULL, "get: failed without MEM_FULL");
+	TEST_CHECK(chunk_c == arena._max_chunk_c, "get: %llu of %llu chunks obtainable",
+		LS_CAST(chunk_c, unsigned long long), LS_CAST(arena._max_chunk_c, unsigned long long));
+}
+
+
+static void test_move(ls_void_p from, ls_void_p to, ls_u64_t chunk_c, ls_void_p user)
+{
+	(void) from;
+	(void) to;
+	(void) chunk_c;
+	(void) user;
+}
+
+static void test_compact_after_flush(void)
+{
+	ls_chunk_arena_s			arena		= ls_chunk_arena_init(memory, sizeof(memory), TEST_CHUNK_SIZE);
+	ls_chunk_arena_magazine_s	magazine	= ls_chunk_arena_magazine_init();
+	ls_result_t					status;
+	ls_u64_t					keep_c		= arena._max_chunk_c / 4;
+	ls_u64_t					moved_c;
+	ls_u64_t					i;
+
+	/* the top quarter stays live, everything below goes through the depot */
+	for (i = 0; i < arena._max_chunk_c; i++)
+	{
+		chunk_a[i] = ls_chunk_arena_magazine_get_chunk(&arena, &magazine, &status);
+	}
+
+	for (i = 0; i < arena._max_chunk_c; i++)
+	{
+		if (LS_CHUNK_ARENA_ADDR_TO_INDEX((&arena), chunk_a[i]) < arena._max_chunk_c - keep_c)
+		{
+			ls_chunk_arena_magazine_delete_chunk(&arena, &magazine, chunk_a[i]);
+		}
+	}
+
+	ls_chunk_arena_magazine_flush(&arena, &magazine);
+
+	TEST_CHECK(LS_CHUNK_ARENA_FREE_INDEX(arena._depot) != 0, "compact: flushing left the depot empty, nothing is tested");
+
+	moved_c = ls_chunk_arena_compact(&arena, test_move, LS_NULL);
+
+	TEST_CHECK(moved_c == keep_c, "compact: moved %llu chunks, %llu expected",
+		LS_CAST(moved_c, unsigned long long), LS_CAST(keep_c, unsigned long long));
+	TEST_CHECK(LS_CHUNK_ARENA_FREE_INDEX(arena._depot) == 0, "compact: the depot still holds chunks");
+	TEST_CHECK(arena._chunk_c == keep_c, "compact: %llu chunks counted live, %llu expected",
+		LS_CAST(arena._chunk_c, unsigned long long), LS_CAST(keep_c, unsigned long long));
+	TEST_CHECK(arena._next_committed_chunk - 1 == keep_c, "compact: top at %llu, %llu expected",
+		LS_CAST(arena._next_committed_chunk - 1, unsigned long long), LS_CAST(keep_c, unsigned long long));
+}
+
+
+int main(void)
+{
+	test_get_after_flush();
+	test_compact_after_flush();
+
+	if (error_c)
+	{
+		printf("FAIL: %u errors\n", error_c);
+		return 1;
+	}
+
+	printf("OK\n");
+	return 0;
+}
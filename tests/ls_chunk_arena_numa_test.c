@@ -0,0 +1,218 @@
+/*
+ * ls_chunk_arena_numa_test.c - test of the NUMA arenas on a simulated topology
+ *
+ *	Build & run
+ *
+ *		cc -std=c11 -O2 -pthread tests/ls_chunk_arena_numa_test.c -o numa_test
+ *		./numa_test
+ *
+ *	LS_CHUNK_ARENA_NUMA_NODE() is overridden by a thread local, so any
+ *	host can play TEST_NODE_C nodes. Checks that gets and deletes stay
+ *	in the region of the caller's node, that gets fall back to the other
+ *	nodes in order once a region is full, and that deletes go back to
+ *	the node owning the chunk whichever node the caller is on. Then
+ *	runs one thread per node and checks none leaves its region.
+ */
+
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdio.h>
+
+/* the memory is static, nothing to commit */
+#define _ls_chunk_arena_alloca_commit_range(memory, offset, range)
+
+static _Thread_local unsigned test_node;
+
+#define LS_CHUNK_ARENA_NUMA_NODE()	test_node
+
+#include "../ls_chunk_arena.h"
+
+
+#define TEST_CHUNK_SIZE		4096
+#define TEST_NODE_C			4
+#define TEST_REGION_SIZE	(64 * TEST_CHUNK_SIZE)
+#define TEST_ROUND_C		20000
+
+
+static _Alignas(TEST_CHUNK_SIZE) ls_u8_t memory[TEST_NODE_C * TEST_REGION_SIZE];
+
+static ls_chunk_arena_numa_s	numa;
+static ls_u32_t					error_c;
+
+
+#define TEST_CHECK(cond, ...)										\
+	do																\
+	{																\
+		if (!(cond))												\
+		{															\
+			__atomic_add_fetch(&error_c, 1, __ATOMIC_RELAXED);		\
+			printf(__VA_ARGS__);									\
+			printf("\n");											\
+		}															\
+	}																\
+	while (0)
+
+
+/* [chunk_p] lies in the region of [node], by address and by the arena that counts it */
+static ls_bool_t test_in_region(ls_void_p chunk_p, ls_u64_t node)
+{
+	ls_u64_t offset = LS_CAST(chunk_p, ls_u64_t) - LS_CAST(LS_CAST(memory, ls_void_p), ls_u64_t);
+
+	return offset / numa._region_size == node && ls_chunk_arena_numa_node_of(&numa, chunk_p) == node;
+}
+
+
+static void test_locality(void)
+{
+	ls_result_t	status = LS_FAIL;
+	ls_void_p	chunk_p;
+	ls_u64_t	node;
+
+	for (node = 0; node < TEST_NODE_C; node++)
+	{
+		test_node	= LS_CAST(node, unsigned);
+		chunk_p		= ls_chunk_arena_numa_get_chunk(&numa, &status);
+
+		TEST_CHECK(status == LS_SUCCESS && test_in_region(chunk_p, node), "locality: node %llu got a chunk of another region",
+			LS_CAST(node, unsigned long long));
+		TEST_CHECK(numa._node_a[node]._chunk_c == 1, "locality: node %llu counts %llu chunks, 1 expected",
+			LS_CAST(node, unsigned long long), LS_CAST(numa._node_a[node]._chunk_c, unsigned long long));
+
+		ls_chunk_arena_numa_delete_chunk(&numa, chunk_p);
+
+		TEST_CHECK(numa._node_a[node]._chunk_c == 0, "locality: node %llu still counts the deleted chunk",
+			LS_CAST(node, unsigned long long));
+	}
+}
+
+
+/* fills every region from node 1, then empties them from node 3 */
+static void test_fallback_and_routing(void)
+{
+	static ls_void_p	chunk_a[TEST_NODE_C * TEST_REGION_SIZE / TEST_CHUNK_SIZE];
+	ls_result_t			status;
+	ls_u64_t			chunk_c = 0;
+	ls_u64_t			expect;
+	ls_u64_t			node;
+	ls_u64_t			i;
+
+	test_node = 1;
+
+	for (node = 0; node < TEST_NODE_C; node++)
+	{
+		/* the caller's node first, then the others in order */
+		expect = (1 + node) % TEST_NODE_C;
+
+		for (i = 0; i < numa._node_a[expect]._max_chunk_c; i++)
+		{
+			chunk_a[chunk_c] = ls_chunk_arena_numa_get_chunk(&numa, &status);
+
+			if (status != LS_SUCCESS || !test_in_region(chunk_a[chunk_c], expect))
+			{
+				TEST_CHECK(0, "fallback: chunk %llu not taken from node %llu",
+					LS_CAST(chunk_c, unsigned long long), LS_CAST(expect, unsigned long long));
+				return;
+			}
+
+			chunk_c++;
+		}
+	}
+
+	TEST_CHECK(ls_chunk_arena_numa_get_chunk(&numa, &status) == LS_NULL && status == LS_CHUNK_ARENA_MEM_FULL,
+		"fallback: got a chunk with every region full");
+
+	/* deleted from another node, every chunk must still go back to its owner */
+	test_node = 3;
+
+	for (i = 0; i < chunk_c; i++)
+	{
+		node = ls_chunk_arena_numa_node_of(&numa, chunk_a[i]);
+		expect = numa._node_a[node]._chunk_c - 1;
+
+		ls_chunk_arena_numa_delete_chunk(&numa, chunk_a[i]);
+
+		TEST_CHECK(numa._node_a[node]._chunk_c == expect, "routing: chunk %llu not returned to node %llu",
+			LS_CAST(i, unsigned long long), LS_CAST(node, unsigned long long));
+	}
+
+	for (node = 0; node < TEST_NODE_C; node++)
+	{
+		TEST_CHECK(numa._node_a[node]._chunk_c == 0, "routing: node %llu counts %llu chunks after deleting all",
+			LS_CAST(node, unsigned long long), LS_CAST(numa._node_a[node]._chunk_c, unsigned long long));
+	}
+}
+
+
+static void *test_worker(void *arg)
+{
+	ls_void_p	held_a[8];
+	ls_result_t	status;
+	ls_u32_t	round_i;
+	ls_u32_t	held_i;
+
+	test_node = LS_CAST(LS_CAST(arg, ls_u64_t), unsigned);
+
+	for (round_i = 0; round_i < TEST_ROUND_C; round_i++)
+	{
+		for (held_i = 0; held_i < 8; held_i++)
+		{
+			held_a[held_i] = ls_chunk_arena_numa_get_chunk(&numa, &status);
+
+			if (status != LS_SUCCESS || !test_in_region(held_a[held_i], test_node))
+			{
+				TEST_CHECK(0, "threads: node %u got a chunk of another region", test_node);
+				return LS_NULL;
+			}
+		}
+
+		for (held_i = 0; held_i < 8; held_i++)
+		{
+			ls_chunk_arena_numa_delete_chunk(&numa, held_a[held_i]);
+		}
+	}
+
+	return LS_NULL;
+}
+
+
+static void test_threads(void)
+{
+	pthread_t	thread_a[TEST_NODE_C];
+	ls_u64_t	node;
+
+	for (node = 0; node < TEST_NODE_C; node++)
+	{
+		pthread_create(&thread_a[node], LS_NULL, test_worker, LS_CAST(node, void *));
+	}
+
+	for (node = 0; node < TEST_NODE_C; node++)
+	{
+		pthread_join(thread_a[node], LS_NULL);
+
+		TEST_CHECK(numa._node_a[node]._chunk_c == 0, "threads: node %llu counts %llu chunks after the run",
+			LS_CAST(node, unsigned long long), LS_CAST(numa._node_a[node]._chunk_c, unsigned long long));
+	}
+}
+
+
+int main(void)
+{
+	ls_chunk_arena_numa_init(&numa, memory, sizeof(memory), TEST_CHUNK_SIZE, TEST_NODE_C);
+
+	test_locality();
+	test_fallback_and_routing();
+	test_threads();
+
+	ls_chunk_arena_numa_fini(&numa);
+
+	if (error_c)
+	{
+		printf("FAIL: %u errors\n", error_c);
+		return 1;
+	}
+
+	printf("OK\n");
+	return 0;
+}